@@ -0,0 +1,158 @@
+// Counts the heap allocations made by the string conversions, per call
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include "utf8.h"
+
+static std::size_t allocation_count = 0;
+
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static std::string make_ascii_data() {
+    std::string s;
+    std::string base =
+        "Hello World! This is pure ASCII text. "
+        "The quick brown fox jumps over the lazy dog. "
+        "<html><body>ASCII only content</body></html> ";
+    for (int i = 0; i < 20; ++i) {
+        s += base;
+    }
+    return s;
+}
+
+static std::string make_cyrillic_html_data() {
+    std::string s;
+    std::string base =
+        "<html><body>"
+        "Hello World! "
+        "Ово је <em>пример</em> текста на <i>српској</i> ћирилици. "
+        "Шницла, ћевапи, <b>доручак</b>. "
+        "Добродошли у UTF-8 тестирање! "
+        "</body></html>";
+    for (int i = 0; i < 20; ++i) {
+        s += base;
+    }
+    return s;
+}
+
+static std::string make_mixed_data() {
+    std::string utf8_data;
+    utf8_data += "Hello World! ";
+    utf8_data += "\xc3\xa9\xc3\xa0"; // éà
+    utf8_data += "\xd1\x88\xd0\xbd\xd0\xb8\xd1\x86\xd0\xbb\xd0\xb0"; // шницла
+    utf8_data += "\xf0\x9f\x98\x80\xf0\x9f\x98\x81"; // 😀😁
+
+    std::string base = utf8_data;
+    for (int i = 0; i < 20; ++i) {
+        utf8_data += base;
+    }
+    return utf8_data;
+}
+
+// Invalid octets sprinkled through the text, one in every stride octets
+static std::string make_invalid_data(std::string s, std::size_t stride = 61) {
+    for (std::size_t i = 7; i < s.size(); i += stride) {
+        s[i] = '\xff';
+    }
+    return s;
+}
+
+template <typename function>
+static void measure(const char* name, std::size_t input_bytes, function f) {
+    const int iterations = 10000;
+    std::size_t sum = 0;
+    const std::size_t allocations_before = allocation_count;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        sum += f();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const std::size_t allocations = allocation_count - allocations_before;
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    double total_mb = static_cast<double>(input_bytes) * iterations / (1024.0 * 1024.0);
+    double time_sec = static_cast<double>(duration.count()) / 1e6;
+    std::cout << name << ","
+              << static_cast<double>(allocations) / iterations << ","
+              << duration.count() << "," << total_mb / time_sec << "," << sum << "\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: allocations <scenario>\n";
+        std::cerr << "Scenarios: ascii, cyrillic, mixed\n";
+        return 1;
+    }
+
+    std::string scenario = argv[1];
+    std::string utf8_data;
+
+    if (scenario == "ascii") {
+        utf8_data = make_ascii_data();
+    } else if (scenario == "cyrillic") {
+        utf8_data = make_cyrillic_html_data();
+    } else if (scenario == "mixed") {
+        utf8_data = make_mixed_data();
+    } else {
+        std::cerr << "Unknown scenario: " << scenario << "\n";
+        return 1;
+    }
+
+    const std::string_view utf8_view = utf8_data;
+    const std::u16string utf16_data = utf8::utf8to16(utf8_view);
+    const std::u32string utf32_data = utf8::utf8to32(utf8_view);
+    const std::string invalid_data = make_invalid_data(utf8_data);
+    const std::string rarely_invalid_data = make_invalid_data(utf8_data, 1000);
+    const std::string often_invalid_data = make_invalid_data(utf8_data, 10);
+
+    std::cout << "Function,Allocations_per_call,Time_us,MB_per_sec,Sum\n";
+
+    // All of them are measured against the size of the UTF-8 text
+    measure("utf8::utf8to16", utf8_data.size(),
+            [&] { return utf8::utf8to16(utf8_view).size(); });
+    measure("utf8::utf16to8", utf8_data.size(),
+            [&] { return utf8::utf16to8(std::u16string_view(utf16_data)).size(); });
+    measure("utf8::utf8to32", utf8_data.size(),
+            [&] { return utf8::utf8to32(utf8_view).size(); });
+    measure("utf8::utf32to8", utf8_data.size(),
+            [&] { return utf8::utf32to8(std::u32string_view(utf32_data)).size(); });
+    measure("utf8::replace_invalid (valid)", utf8_data.size(),
+            [&] { return utf8::replace_invalid(utf8_view).size(); });
+    measure("utf8::replace_invalid (invalid)", invalid_data.size(),
+            [&] { return utf8::replace_invalid(std::string_view(invalid_data)).size(); });
+    measure("utf8::replace_invalid (0.1% invalid)", rarely_invalid_data.size(),
+            [&] { return utf8::replace_invalid(std::string_view(rarely_invalid_data)).size(); });
+    measure("utf8::replace_invalid (10% invalid)", often_invalid_data.size(),
+            [&] { return utf8::replace_invalid(std::string_view(often_invalid_data)).size(); });
+    std::string sanitized_data = utf8_data;
+    measure("utf8::sanitize (valid)", utf8_data.size(),
+            [&] { return utf8::sanitize(sanitized_data); });
+    // Converting dirty text: replacing first costs a temporary string and a second pass
+    measure("utf8::replace_invalid + utf8::utf8to16 (invalid)", invalid_data.size(),
+            [&] { return utf8::utf8to16(utf8::replace_invalid(std::string_view(invalid_data))).size(); });
+    measure("utf8::utf8to16 with on_error::replace (invalid)", invalid_data.size(), [&] {
+        std::u16string utf16;
+        // Never more code units than octets, replacements included
+        utf16.reserve(invalid_data.size());
+        utf8::utf8to16(invalid_data.begin(), invalid_data.end(), std::back_inserter(utf16), utf8::on_error::replace());
+        return utf16.size();
+    });
+
+    return 0;
+}
@@ -3,6 +3,12 @@
 #include <string>
 #include <vector>
 #include "utf8.h"
+#if defined(__has_include)
+#if __has_include("utf8/parallel.h")
+#include "utf8/parallel.h"
+#define UTF8CPP_BENCHMARK_PARALLEL
+#endif
+#endif
 
 static std::string make_ascii_data() {
     std::string s;
@@ -48,10 +54,22 @@ static std::string make_mixed_data() {
     return utf8_data;
 }
 
+// Mixed content repeated up to 1 GB, for the multi-threaded validation
+static std::string make_1gb_data() {
+    const std::size_t size = std::size_t(1) << 30;
+    std::string s = make_mixed_data();
+    s.reserve(size + s.size());
+    while (s.size() < size / 2) {
+        s += s;
+    }
+    s.append(s, 0, size - s.size());
+    return s;
+}
+
 int main(int argc, char** argv) {
     if (argc < 2) {
         std::cerr << "Usage: benchmark <scenario>\n";
-        std::cerr << "Scenarios: ascii, cyrillic, mixed\n";
+        std::cerr << "Scenarios: ascii, cyrillic, mixed, 1gb\n";
         return 1;
     }
 
@@ -64,12 +82,14 @@ int main(int argc, char** argv) {
         utf8_data = make_cyrillic_html_data();
     } else if (scenario == "mixed") {
         utf8_data = make_mixed_data();
+    } else if (scenario == "1gb") {
+        utf8_data = make_1gb_data();
     } else {
         std::cerr << "Unknown scenario: " << scenario << "\n";
         return 1;
     }
 
-    const int iterations = 100000;
+    const int iterations = (scenario == "1gb") ? 1 : 100000;
 
     auto start = std::chrono::high_resolution_clock::now();
     for (int i = 0; i < iterations; ++i) {
@@ -104,6 +124,108 @@ int main(int argc, char** argv) {
     auto duration_find_invalid =
         std::chrono::duration_cast<std::chrono::microseconds>(end - start);
 
+    start = std::chrono::high_resolution_clock::now();
+    std::ptrdiff_t distance_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        distance_sum += utf8::distance(utf8_data.data(), utf8_data.data() + utf8_data.size());
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_distance =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::ptrdiff_t unchecked_distance_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        unchecked_distance_sum += utf8::unchecked::distance(utf8_data.data(), utf8_data.data() + utf8_data.size());
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_unchecked_distance =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    // There and back again: every iteration moves over the text twice
+    const char* const data_begin = utf8_data.data();
+    const char* const data_end = data_begin + utf8_data.size();
+    const std::ptrdiff_t code_points = utf8::distance(data_begin, data_end);
+    start = std::chrono::high_resolution_clock::now();
+    std::ptrdiff_t advance_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const char* it = data_begin;
+        utf8::advance(it, code_points, data_end);
+        advance_sum += it - data_begin;
+        utf8::advance(it, -code_points, data_begin);
+        advance_sum += it - data_begin;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_advance =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::ptrdiff_t unchecked_advance_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const char* it = data_begin;
+        utf8::unchecked::advance(it, code_points);
+        unchecked_advance_sum += it - data_begin;
+        utf8::unchecked::advance(it, -code_points);
+        unchecked_advance_sum += it - data_begin;
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_unchecked_advance =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::size_t utf32_length_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        utf32_length_sum += utf8::utf8to32(utf8_data).size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_utf8to32 =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    const std::u32string utf32_data = utf8::utf8to32(utf8_data);
+    start = std::chrono::high_resolution_clock::now();
+    std::size_t utf8_length_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        utf8_length_sum += utf8::utf32to8(utf32_data).size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_utf32to8 =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    // Validating first and converting unchecked reads the input twice
+    std::u16string utf16_buffer(utf8_data.size(), u'\0');
+    start = std::chrono::high_resolution_clock::now();
+    std::size_t two_pass_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        if (utf8::is_valid(utf8_data))
+            two_pass_sum += static_cast<std::size_t>(
+                utf8::unchecked::utf8to16(utf8_data.data(), utf8_data.data() + utf8_data.size(), &utf16_buffer[0]) - &utf16_buffer[0]);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_two_pass =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+    start = std::chrono::high_resolution_clock::now();
+    std::size_t fused_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        const auto result = utf8::try_utf8to16(utf8_data.data(), utf8_data.data() + utf8_data.size(), &utf16_buffer[0]);
+        fused_sum += static_cast<std::size_t>(result.out - &utf16_buffer[0]);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_fused =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+#ifdef UTF8CPP_BENCHMARK_PARALLEL
+    const unsigned thread_count = std::thread::hardware_concurrency();
+    start = std::chrono::high_resolution_clock::now();
+    std::size_t parallel_index_sum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        parallel_index_sum += utf8::find_invalid(utf8_data, thread_count);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    auto duration_parallel =
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+#endif
+
     size_t total_bytes =
         static_cast<size_t>(iterations) * utf8_data.size();
     double total_mb = static_cast<double>(total_bytes) / (1024.0 * 1024.0);
@@ -125,5 +247,53 @@ int main(int argc, char** argv) {
     std::cout << "utf8::find_invalid," << duration_find_invalid.count() << ","
               << total_mb << "," << find_invalid_mbs << "," << invalid_index_sum << "\n";
 
+    double distance_time_sec = static_cast<double>(duration_distance.count()) / 1e6;
+    double distance_mbs = total_mb / distance_time_sec;
+    std::cout << "utf8::distance," << duration_distance.count() << ","
+              << total_mb << "," << distance_mbs << "," << distance_sum << "\n";
+
+    double unchecked_distance_time_sec = static_cast<double>(duration_unchecked_distance.count()) / 1e6;
+    double unchecked_distance_mbs = total_mb / unchecked_distance_time_sec;
+    std::cout << "utf8::unchecked::distance," << duration_unchecked_distance.count() << ","
+              << total_mb << "," << unchecked_distance_mbs << "," << unchecked_distance_sum << "\n";
+
+    double advance_time_sec = static_cast<double>(duration_advance.count()) / 1e6;
+    double advance_mbs = 2 * total_mb / advance_time_sec;
+    std::cout << "utf8::advance," << duration_advance.count() << ","
+              << 2 * total_mb << "," << advance_mbs << "," << advance_sum << "\n";
+
+    double unchecked_advance_time_sec = static_cast<double>(duration_unchecked_advance.count()) / 1e6;
+    double unchecked_advance_mbs = 2 * total_mb / unchecked_advance_time_sec;
+    std::cout << "utf8::unchecked::advance," << duration_unchecked_advance.count() << ","
+              << 2 * total_mb << "," << unchecked_advance_mbs << "," << unchecked_advance_sum << "\n";
+
+    // Both conversions are measured against the size of the UTF-8 text
+    double utf8to32_time_sec = static_cast<double>(duration_utf8to32.count()) / 1e6;
+    double utf8to32_mbs = total_mb / utf8to32_time_sec;
+    std::cout << "utf8::utf8to32," << duration_utf8to32.count() << ","
+              << total_mb << "," << utf8to32_mbs << "," << utf32_length_sum << "\n";
+
+    double utf32to8_time_sec = static_cast<double>(duration_utf32to8.count()) / 1e6;
+    double utf32to8_mbs = total_mb / utf32to8_time_sec;
+    std::cout << "utf8::utf32to8," << duration_utf32to8.count() << ","
+              << total_mb << "," << utf32to8_mbs << "," << utf8_length_sum << "\n";
+
+    double two_pass_time_sec = static_cast<double>(duration_two_pass.count()) / 1e6;
+    double two_pass_mbs = total_mb / two_pass_time_sec;
+    std::cout << "utf8::is_valid + utf8::unchecked::utf8to16," << duration_two_pass.count() << ","
+              << total_mb << "," << two_pass_mbs << "," << two_pass_sum << "\n";
+
+    double fused_time_sec = static_cast<double>(duration_fused.count()) / 1e6;
+    double fused_mbs = total_mb / fused_time_sec;
+    std::cout << "utf8::try_utf8to16," << duration_fused.count() << ","
+              << total_mb << "," << fused_mbs << "," << fused_sum << "\n";
+
+#ifdef UTF8CPP_BENCHMARK_PARALLEL
+    double parallel_time_sec = static_cast<double>(duration_parallel.count()) / 1e6;
+    double parallel_mbs = total_mb / parallel_time_sec;
+    std::cout << "utf8::find_invalid (parallel)," << duration_parallel.count() << ","
+              << total_mb << "," << parallel_mbs << "," << parallel_index_sum << "\n";
+#endif
+
     return 0;
 }
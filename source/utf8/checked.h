@@ -93,35 +93,47 @@ namespace utf8
         return internal::append16(cp, result);
     }
 
+namespace internal
+{
+    // Moves past an invalid UTF-8 sequence the way replace_invalid does: an
+    // invalid lead octet on its own, otherwise together with the trail
+    // octets that follow it
+    template <typename octet_iterator>
+    void skip_invalid_sequence(octet_iterator& it, octet_iterator end, utf_error err_code)
+    {
+        ++it;
+        if (err_code != INVALID_LEAD)
+            while (it != end && (err_code == NOT_ENOUGH_ROOM || utf8::internal::is_trail(*it)))
+                ++it;
+    }
+} // namespace internal
+
     template <typename octet_iterator, typename output_iterator>
     output_iterator replace_invalid(octet_iterator start, octet_iterator end, output_iterator out, utfchar32_t replacement)
     {
+        // Encoded once, and checked when it is first needed
+        char marker[4];
+        const char* const marker_end = utf8::internal::append(replacement, marker);
         while (start != end) {
+            // Contiguous input: the valid run is found by the vectorized validator
+            // and copied in one block
+            const octet_iterator valid_end = utf8::internal::skip_valid(start, end);
+            out = utf8::internal::copy_run(start, valid_end, out);
+            start = valid_end;
+            if (start == end)
+                break;
             octet_iterator sequence_start = start;
-            internal::utf_error err_code = utf8::internal::validate_next(start, end);
-            switch (err_code) {
-                case internal::UTF8_OK :
-                    for (octet_iterator it = sequence_start; it != start; ++it)
-                        *out++ = *it;
-                    break;
-                case internal::NOT_ENOUGH_ROOM:
-                    out = utf8::append (replacement, out);
-                    start = end;
-                    break;
-                case internal::INVALID_LEAD:
-                    out = utf8::append (replacement, out);
-                    ++start;
-                    break;
-                case internal::INCOMPLETE_SEQUENCE:
-                case internal::OVERLONG_SEQUENCE:
-                case internal::INVALID_CODE_POINT:
-                    out = utf8::append (replacement, out);
-                    ++start;
-                    // just one replacement mark for the sequence
-                    while (start != end && utf8::internal::is_trail(*start))
-                        ++start;
-                    break;
+            utfchar32_t cp;
+            const internal::utf_error err_code = utf8::internal::decode_next(start, end, cp);
+            if (err_code == internal::UTF8_OK) {
+                out = utf8::internal::copy_run(sequence_start, start, out);
+                continue;
             }
+            if (!utf8::internal::is_code_point_valid(replacement))
+                throw invalid_code_point(replacement);
+            // just one replacement mark for the sequence
+            out = utf8::internal::copy_octets(marker, marker_end, out);
+            utf8::internal::skip_invalid_sequence(start, end, err_code);
         }
         return out;
     }
@@ -133,18 +145,159 @@ namespace utf8
         return utf8::replace_invalid(start, end, out, replacement_marker);
     }
 
-    inline std::string replace_invalid(const std::string& s, utfchar32_t replacement)
+namespace internal
+{
+    struct invalid_octet_counter {
+        std::size_t sequences;
+        std::size_t octets;
+        invalid_octet_counter() : sequences(0), octets(0) {}
+        void operator () (const invalid_sequence& sequence)
+        {
+            ++sequences;
+            octets += sequence.length;
+        }
+    };
+
+    // The string overloads of replace_invalid: the invalid sequences are
+    // counted first, so that the result is allocated only once and written
+    // through a pointer. for_each_invalid reports exactly the sequences
+    // that replace_invalid replaces. Both passes read the input through
+    // pointers, so that they take the contiguous paths.
+    template <typename string_type, typename octet_type>
+    string_type replace_invalid_string(const octet_type* start, const octet_type* end, utfchar32_t replacement)
     {
-        std::string result;
-        replace_invalid(s.begin(), s.end(), std::back_inserter(result), replacement);
+        const invalid_octet_counter invalid = utf8::for_each_invalid(start, end, invalid_octet_counter());
+        if (invalid.sequences == 0)
+            return string_type(start, end);
+        if (!utf8::internal::is_code_point_valid(replacement))
+            throw invalid_code_point(replacement);
+        string_type result(static_cast<std::size_t>(end - start) - invalid.octets +
+                           invalid.sequences * utf8::internal::utf8_length_of(replacement),
+                           typename string_type::value_type());
+        utf8::replace_invalid(start, end, &result[0], replacement);
         return result;
     }
+} // namespace internal
+
+    inline std::string replace_invalid(const std::string& s, utfchar32_t replacement)
+    {
+        return utf8::internal::replace_invalid_string<std::string>(s.data(), s.data() + s.size(), replacement);
+    }
 
     inline std::string replace_invalid(const std::string& s)
     {
-        std::string result;
-        replace_invalid(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::replace_invalid_string<std::string>(s.data(), s.data() + s.size(),
+                                                                    static_cast<utfchar32_t>(0xfffd));
+    }
+
+namespace internal
+{
+    // How much replacing the invalid sequences changes the length of the
+    // text, and how far the output gets ahead of the input on the way
+    struct replacement_growth {
+        std::ptrdiff_t marker_length;
+        std::ptrdiff_t growth;
+        std::ptrdiff_t max_growth;
+        std::size_t sequences;
+        explicit replacement_growth(std::ptrdiff_t length) : marker_length(length), growth(0), max_growth(0), sequences(0) {}
+        void operator () (const invalid_sequence& sequence)
+        {
+            ++sequences;
+            growth += marker_length - static_cast<std::ptrdiff_t>(sequence.length);
+            if (growth > max_growth)
+                max_growth = growth;
+        }
+    };
+
+    // Writes the input with its invalid sequences replaced to out, which
+    // must not get ahead of the part of the input yet to be read
+    struct in_place_replacer {
+        const char* input;
+        std::size_t copied;
+        char* out;
+        const char* marker;
+        const char* marker_end;
+        in_place_replacer(const char* text, char* result, const char* replacement, const char* replacement_end) :
+            input(text), copied(0), out(result), marker(replacement), marker_end(replacement_end) {}
+        void operator () (const invalid_sequence& sequence)
+        {
+            const std::size_t run = sequence.offset - copied;
+            std::memmove(out, input + copied, run);
+            out += run;
+            for (const char* it = marker; it != marker_end; ++it)
+                *out++ = *it;
+            copied = sequence.offset + sequence.length;
+        }
+    };
+
+    // Replaces the invalid sequences in [text, text + length), the first of
+    // them at the start, in place. The buffer must have room for
+    // growth.max_growth more octets: the text is moved that far ahead
+    // first, so that the output never overwrites the input it still needs.
+    inline void replace_in_place(char* text, std::size_t length, const replacement_growth& growth, utfchar32_t replacement)
+    {
+        char marker[4];
+        const char* const marker_end = utf8::internal::append(replacement, marker);
+        const std::size_t headroom = static_cast<std::size_t>(growth.max_growth);
+        std::memmove(text + headroom, text, length);
+        const char* const input = text + headroom;
+        const in_place_replacer replacer = utf8::for_each_invalid(input, input + length,
+                                                                   in_place_replacer(input, text, marker, marker_end));
+        std::memmove(replacer.out, input + replacer.copied, length - replacer.copied);
+    }
+} // namespace internal
+
+    // Replaces the invalid sequences in place, and returns how many there
+    // were. Valid text is neither written nor reallocated; the string grows
+    // only if the replacements take more room than the sequences they replace.
+    inline std::size_t sanitize(std::string& s, utfchar32_t replacement)
+    {
+        const char* const start = s.data();
+        const char* const end = start + s.size();
+        const char* const invalid = utf8::internal::find_invalid(start, end);
+        if (invalid == end)
+            return 0;
+        if (!utf8::internal::is_code_point_valid(replacement))
+            throw invalid_code_point(replacement);
+        const std::size_t first = static_cast<std::size_t>(invalid - start);
+        const std::size_t length = s.size() - first;
+        const internal::replacement_growth growth = utf8::for_each_invalid(invalid, end,
+            internal::replacement_growth(static_cast<std::ptrdiff_t>(utf8::internal::utf8_length_of(replacement))));
+        if (growth.max_growth > 0)
+            s.resize(s.size() + static_cast<std::size_t>(growth.max_growth));
+        utf8::internal::replace_in_place(&s[first], length, growth, replacement);
+        s.resize(static_cast<std::size_t>(static_cast<std::ptrdiff_t>(first + length) + growth.growth));
+        return growth.sequences;
+    }
+
+    inline std::size_t sanitize(std::string& s)
+    {
+        return utf8::sanitize(s, static_cast<utfchar32_t>(0xfffd));
+    }
+
+    // The same for a buffer of capacity octets that holds length octets of
+    // text; not_enough_room is thrown, with the buffer left as it is, if
+    // the replacements do not fit
+    inline std::size_t sanitize(char* s, std::size_t& length, std::size_t capacity, utfchar32_t replacement)
+    {
+        char* const invalid = utf8::internal::find_invalid(s, s + length);
+        if (invalid == s + length)
+            return 0;
+        if (!utf8::internal::is_code_point_valid(replacement))
+            throw invalid_code_point(replacement);
+        const std::size_t tail = static_cast<std::size_t>(s + length - invalid);
+        const internal::replacement_growth growth = utf8::for_each_invalid(invalid, s + length,
+            internal::replacement_growth(static_cast<std::ptrdiff_t>(utf8::internal::utf8_length_of(replacement))));
+        if (static_cast<std::size_t>(growth.max_growth) > capacity - length)
+            throw not_enough_room();
+        utf8::internal::replace_in_place(invalid, tail, growth, replacement);
+        length = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(length) + growth.growth);
+        return growth.sequences;
+    }
+
+    inline std::size_t sanitize(char* s, std::size_t& length, std::size_t capacity)
+    {
+        return utf8::sanitize(s, length, capacity, static_cast<utfchar32_t>(0xfffd));
     }
 
     template <typename octet_iterator>
@@ -204,13 +357,15 @@ namespace utf8
     void advance (octet_iterator& it, distance_type n, octet_iterator end)
     {
         const distance_type zero(0);
+        // Contiguous input: the code points the validator vouches for are
+        // passed in bulk, and only the rest one at a time
         if (n < zero) {
             // backward
-            for (distance_type i = n; i < zero; ++i)
+            for (distance_type i = n + static_cast<distance_type>(utf8::internal::skip_valid_code_points_back(end, it, -static_cast<std::ptrdiff_t>(n))); i < zero; ++i)
                 utf8::prior(it, end);
         } else {
             // forward
-            for (distance_type i = zero; i < n; ++i)
+            for (distance_type i = static_cast<distance_type>(utf8::internal::skip_valid_code_points(it, end, static_cast<std::ptrdiff_t>(n))); i < n; ++i)
                 utf8::next(it, end);
         }
     }
@@ -219,16 +374,60 @@ namespace utf8
     typename std::iterator_traits<octet_iterator>::difference_type
     distance (octet_iterator first, octet_iterator last)
     {
-        typename std::iterator_traits<octet_iterator>::difference_type dist;
-        for (dist = 0; first < last; ++dist)
-            utf8::next(first, last);
+        typename std::iterator_traits<octet_iterator>::difference_type dist = 0;
+        while (first < last) {
+            // Contiguous input: the valid run is found by the vectorized validator
+            const octet_iterator valid_end = utf8::internal::skip_valid(first, last);
+            dist += utf8::internal::count_code_points(first, valid_end);
+            first = valid_end;
+            if (first < last) {
+                utf8::next(first, last);
+                ++dist;
+            }
+        }
         return dist;
     }
 
+    // Error policies for the conversions: what to do with invalid input
+namespace on_error
+{
+    // Throw, as the conversions without a policy do
+    struct throw_exception {};
+
+    // Write a code point in place of each invalid sequence, U+FFFD by default
+    struct replace {
+        utfchar32_t replacement;
+        explicit replace(utfchar32_t cp = 0xfffd) : replacement(cp) {}
+    };
+
+    // Drop the invalid sequences
+    struct skip {};
+
+    // Stop at the first invalid sequence and report it
+    struct stop {};
+} // namespace on_error
+
+namespace internal
+{
+    inline bool replacement_for(on_error::replace policy, utfchar32_t& cp)
+    {
+        cp = policy.replacement;
+        return true;
+    }
+
+    inline bool replacement_for(on_error::skip, utfchar32_t&)
+    {
+        return false;
+    }
+} // namespace internal
+
     template <typename u16bit_iterator, typename octet_iterator>
     octet_iterator utf16to8 (u16bit_iterator start, u16bit_iterator end, octet_iterator result)
     {
         while (start != end) {
+            start = utf8::internal::utf16to8_blocks(start, end, result);
+            if (start == end)
+                break;
             utfchar32_t cp = static_cast<utfchar32_t>(utf8::internal::mask16(*start++));
             // Take care of surrogate pairs first
             if (utf8::internal::is_lead_surrogate(cp)) {
@@ -256,6 +455,12 @@ namespace utf8
     u16bit_iterator utf8to16 (octet_iterator start, octet_iterator end, u16bit_iterator result)
     {
         while (start < end) {
+            start = utf8::internal::utf8to16_blocks(start, end, result);
+            // ASCII runs of contiguous input map one to one
+            for (const octet_iterator ascii_end = utf8::internal::skip_ascii(start, end); start != ascii_end; ++start)
+                *result++ = static_cast<utfchar16_t>(utf8::internal::mask8(*start));
+            if (start == end)
+                break;
             const utfchar32_t cp = utf8::next(start, end);
             if (cp > 0xffff) { //make a surrogate pair
                 *result++ = static_cast<utfchar16_t>((cp >> 10)   + internal::LEAD_OFFSET);
@@ -270,8 +475,12 @@ namespace utf8
     template <typename octet_iterator, typename u32bit_iterator>
     octet_iterator utf32to8 (u32bit_iterator start, u32bit_iterator end, octet_iterator result)
     {
-        while (start != end)
+        while (start != end) {
+            start = utf8::internal::utf32to8_blocks(start, end, result);
+            if (start == end)
+                break;
             result = utf8::append(*(start++), result);
+        }
 
         return result;
     }
@@ -279,12 +488,361 @@ namespace utf8
     template <typename octet_iterator, typename u32bit_iterator>
     u32bit_iterator utf8to32 (octet_iterator start, octet_iterator end, u32bit_iterator result)
     {
-        while (start < end)
-            (*result++) = utf8::next(start, end);
+        while (start < end) {
+            start = utf8::internal::utf8to32_blocks(start, end, result);
+            for (const octet_iterator ascii_end = utf8::internal::skip_ascii(start, end); start != ascii_end; ++start)
+                (*result++) = utf8::internal::mask8(*start);
+            if (start != end)
+                (*result++) = utf8::next(start, end);
+        }
+
+        return result;
+    }
+
+    // The conversions with an error policy. Valid input takes the same code
+    // paths as with the conversions above; the policy only comes into play
+    // at an invalid sequence. on_error::replace and on_error::skip share the
+    // generic overloads, the other two have their own.
+    template <typename u16bit_iterator, typename octet_iterator, typename error_policy>
+    octet_iterator utf16to8 (u16bit_iterator start, u16bit_iterator end, octet_iterator result, error_policy policy)
+    {
+        utfchar32_t replacement = 0;
+        while (utf8::internal::utf16to8_until_invalid(start, end, result) != internal::UTF8_OK) {
+            // Every invalid code unit is an invalid sequence of its own
+            ++start;
+            if (utf8::internal::replacement_for(policy, replacement))
+                result = utf8::append(replacement, result);
+        }
+        return result;
+    }
+
+    template <typename u16bit_iterator, typename octet_iterator>
+    octet_iterator utf16to8 (u16bit_iterator start, u16bit_iterator end, octet_iterator result, on_error::throw_exception)
+    {
+        return utf8::utf16to8(start, end, result);
+    }
+
+    template <typename u16bit_iterator, typename octet_iterator>
+    transcoding_result<octet_iterator> utf16to8 (u16bit_iterator start, u16bit_iterator end, octet_iterator result, on_error::stop)
+    {
+        u16bit_iterator it = start;
+        const internal::utf_error err_code = utf8::internal::utf16to8_until_invalid(it, end, result);
+        return utf8::internal::make_transcoding_result(result, static_cast<std::size_t>(std::distance(start, it)), err_code);
+    }
+
+    template <typename u16bit_iterator, typename octet_iterator, typename error_policy>
+    u16bit_iterator utf8to16 (octet_iterator start, octet_iterator end, u16bit_iterator result, error_policy policy)
+    {
+        utfchar32_t replacement = 0;
+        internal::utf_error err_code;
+        while ((err_code = utf8::internal::utf8to16_until_invalid(start, end, result)) != internal::UTF8_OK) {
+            utf8::internal::skip_invalid_sequence(start, end, err_code);
+            if (utf8::internal::replacement_for(policy, replacement))
+                result = utf8::append16(replacement, result);
+        }
+        return result;
+    }
+
+    template <typename u16bit_iterator, typename octet_iterator>
+    u16bit_iterator utf8to16 (octet_iterator start, octet_iterator end, u16bit_iterator result, on_error::throw_exception)
+    {
+        return utf8::utf8to16(start, end, result);
+    }
+
+    template <typename u16bit_iterator, typename octet_iterator>
+    transcoding_result<u16bit_iterator> utf8to16 (octet_iterator start, octet_iterator end, u16bit_iterator result, on_error::stop)
+    {
+        return utf8::try_utf8to16(start, end, result);
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator, typename error_policy>
+    octet_iterator utf32to8 (u32bit_iterator start, u32bit_iterator end, octet_iterator result, error_policy policy)
+    {
+        utfchar32_t replacement = 0;
+        while (utf8::internal::utf32to8_until_invalid(start, end, result) != internal::UTF8_OK) {
+            ++start;
+            if (utf8::internal::replacement_for(policy, replacement))
+                result = utf8::append(replacement, result);
+        }
+        return result;
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator>
+    octet_iterator utf32to8 (u32bit_iterator start, u32bit_iterator end, octet_iterator result, on_error::throw_exception)
+    {
+        return utf8::utf32to8(start, end, result);
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator>
+    transcoding_result<octet_iterator> utf32to8 (u32bit_iterator start, u32bit_iterator end, octet_iterator result, on_error::stop)
+    {
+        u32bit_iterator it = start;
+        const internal::utf_error err_code = utf8::internal::utf32to8_until_invalid(it, end, result);
+        return utf8::internal::make_transcoding_result(result, static_cast<std::size_t>(std::distance(start, it)), err_code);
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator, typename error_policy>
+    u32bit_iterator utf8to32 (octet_iterator start, octet_iterator end, u32bit_iterator result, error_policy policy)
+    {
+        utfchar32_t replacement = 0;
+        internal::utf_error err_code;
+        while ((err_code = utf8::internal::utf8to32_until_invalid(start, end, result)) != internal::UTF8_OK) {
+            utf8::internal::skip_invalid_sequence(start, end, err_code);
+            if (utf8::internal::replacement_for(policy, replacement)) {
+                if (!utf8::internal::is_code_point_valid(replacement))
+                    throw invalid_code_point(replacement);
+                *result++ = replacement;
+            }
+        }
+        return result;
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator>
+    u32bit_iterator utf8to32 (octet_iterator start, octet_iterator end, u32bit_iterator result, on_error::throw_exception)
+    {
+        return utf8::utf8to32(start, end, result);
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator>
+    transcoding_result<u32bit_iterator> utf8to32 (octet_iterator start, octet_iterator end, u32bit_iterator result, on_error::stop)
+    {
+        return utf8::try_utf8to32(start, end, result);
+    }
+
+    // Latin-1 (ISO-8859-1): every octet is the code point of the same value
+    template <typename latin1_iterator, typename octet_iterator>
+    octet_iterator latin1to8 (latin1_iterator start, latin1_iterator end, octet_iterator result)
+    {
+        while (start != end) {
+            start = utf8::internal::latin1to8_blocks(start, end, result);
+            if (start == end)
+                break;
+            result = utf8::append(static_cast<utfchar32_t>(utf8::internal::mask8(*(start++))), result);
+        }
+        return result;
+    }
+
+    template <typename octet_iterator, typename latin1_iterator>
+    latin1_iterator utf8tolatin1 (octet_iterator start, octet_iterator end, latin1_iterator result)
+    {
+        while (start < end) {
+            start = utf8::internal::utf8tolatin1_blocks(start, end, result);
+            if (start == end)
+                break;
+            const utfchar32_t cp = utf8::next(start, end);
+            if (cp > 0xff)
+                throw invalid_code_point(cp);
+            const char octet = static_cast<char>(cp);
+            result = utf8::internal::copy_octets(&octet, &octet + 1, result);
+        }
+        return result;
+    }
+
+namespace internal
+{
+    // Reads a code unit stored as bytes in the given order
+    template <byte_order order, typename unit_type, typename byte_iterator>
+    utfchar32_t read_unit(byte_iterator& it, byte_iterator end)
+    {
+        utfchar32_t unit = 0;
+        for (std::size_t i = 0; i < sizeof(unit_type); ++i) {
+            if (it == end)
+                throw not_enough_room();
+            const utfchar32_t octet = utf8::internal::mask8(*it++);
+            unit |= octet << (8 * ((order == big_endian) ? sizeof(unit_type) - 1 - i : i));
+        }
+        return unit;
+    }
+
+    template <byte_order order, typename byte_iterator, typename octet_iterator>
+    octet_iterator utf16_bytes_to8(byte_iterator start, byte_iterator end, octet_iterator result)
+    {
+        while (start != end) {
+            start = utf8::internal::units_to8_blocks<order, uint16_t>(start, end, result);
+            if (start == end)
+                break;
+            utfchar32_t cp = utf8::internal::read_unit<order, uint16_t>(start, end);
+            if (utf8::internal::is_lead_surrogate(cp)) {
+                if (start == end)
+                    throw invalid_utf16(static_cast<utfchar16_t>(cp));
+                const utfchar32_t trail_surrogate = utf8::internal::read_unit<order, uint16_t>(start, end);
+                if (!utf8::internal::is_trail_surrogate(trail_surrogate))
+                    throw invalid_utf16(static_cast<utfchar16_t>(trail_surrogate));
+                cp = (cp << 10) + trail_surrogate + internal::SURROGATE_OFFSET;
+            }
+            else if (utf8::internal::is_trail_surrogate(cp))
+                throw invalid_utf16(static_cast<utfchar16_t>(cp));
+            result = utf8::append(cp, result);
+        }
+        return result;
+    }
+
+    template <byte_order order, typename octet_iterator, typename byte_iterator>
+    byte_iterator utf8_to16_bytes(octet_iterator start, octet_iterator end, byte_iterator result)
+    {
+        while (start < end) {
+            start = utf8::internal::utf8_to_units_blocks<order, uint16_t>(start, end, result);
+            if (start == end)
+                break;
+            const utfchar32_t cp = utf8::next(start, end);
+            if (cp > 0xffff) { //make a surrogate pair
+                result = utf8::internal::write_unit<order, uint16_t>((cp >> 10) + internal::LEAD_OFFSET, result);
+                result = utf8::internal::write_unit<order, uint16_t>((cp & 0x3ff) + internal::TRAIL_SURROGATE_MIN, result);
+            }
+            else
+                result = utf8::internal::write_unit<order, uint16_t>(cp, result);
+        }
+        return result;
+    }
 
+    template <byte_order order, typename byte_iterator, typename octet_iterator>
+    octet_iterator utf32_bytes_to8(byte_iterator start, byte_iterator end, octet_iterator result)
+    {
+        while (start != end) {
+            start = utf8::internal::units_to8_blocks<order, uint32_t>(start, end, result);
+            if (start == end)
+                break;
+            result = utf8::append(utf8::internal::read_unit<order, uint32_t>(start, end), result);
+        }
         return result;
     }
 
+    template <byte_order order, typename octet_iterator, typename byte_iterator>
+    byte_iterator utf8_to32_bytes(octet_iterator start, octet_iterator end, byte_iterator result)
+    {
+        while (start < end) {
+            start = utf8::internal::utf8_to_units_blocks<order, uint32_t>(start, end, result);
+            if (start != end)
+                result = utf8::internal::write_unit<order, uint32_t>(utf8::next(start, end), result);
+        }
+        return result;
+    }
+} // namespace internal
+
+    // UTF-16 and UTF-32 stored as big-endian or little-endian bytes,
+    // whatever the byte order of the platform
+    template <typename byte_iterator, typename octet_iterator>
+    octet_iterator utf16be_to8 (byte_iterator start, byte_iterator end, octet_iterator result)
+    {
+        return utf8::internal::utf16_bytes_to8<internal::big_endian>(start, end, result);
+    }
+
+    template <typename byte_iterator, typename octet_iterator>
+    octet_iterator utf16le_to8 (byte_iterator start, byte_iterator end, octet_iterator result)
+    {
+        return utf8::internal::utf16_bytes_to8<internal::little_endian>(start, end, result);
+    }
+
+    template <typename octet_iterator, typename byte_iterator>
+    byte_iterator utf8to16be (octet_iterator start, octet_iterator end, byte_iterator result)
+    {
+        return utf8::internal::utf8_to16_bytes<internal::big_endian>(start, end, result);
+    }
+
+    template <typename octet_iterator, typename byte_iterator>
+    byte_iterator utf8to16le (octet_iterator start, octet_iterator end, byte_iterator result)
+    {
+        return utf8::internal::utf8_to16_bytes<internal::little_endian>(start, end, result);
+    }
+
+    template <typename byte_iterator, typename octet_iterator>
+    octet_iterator utf32be_to8 (byte_iterator start, byte_iterator end, octet_iterator result)
+    {
+        return utf8::internal::utf32_bytes_to8<internal::big_endian>(start, end, result);
+    }
+
+    template <typename byte_iterator, typename octet_iterator>
+    octet_iterator utf32le_to8 (byte_iterator start, byte_iterator end, octet_iterator result)
+    {
+        return utf8::internal::utf32_bytes_to8<internal::little_endian>(start, end, result);
+    }
+
+    template <typename octet_iterator, typename byte_iterator>
+    byte_iterator utf8to32be (octet_iterator start, octet_iterator end, byte_iterator result)
+    {
+        return utf8::internal::utf8_to32_bytes<internal::big_endian>(start, end, result);
+    }
+
+    template <typename octet_iterator, typename byte_iterator>
+    byte_iterator utf8to32le (octet_iterator start, octet_iterator end, byte_iterator result)
+    {
+        return utf8::internal::utf8_to32_bytes<internal::little_endian>(start, end, result);
+    }
+
+namespace internal
+{
+    // The string overloads of the conversions: the result is sized up front
+    // and written through a pointer, so it is allocated only once. The
+    // lengths are never less than what is written before an exception, but
+    // they can be zero for invalid input, which still has to throw.
+    template <typename string_type, typename octet_type>
+    string_type utf8to16_string(const octet_type* start, const octet_type* end)
+    {
+        string_type result(utf8::utf16_length_from_utf8(start, end), typename string_type::value_type());
+        if (!result.empty())
+            utf8::utf8to16(start, end, &result[0]);
+        else
+            utf8::utf8to16(start, end, std::back_inserter(result));
+        return result;
+    }
+
+    template <typename string_type, typename word_type>
+    string_type utf16to8_string(const word_type* start, const word_type* end)
+    {
+        string_type result(utf8::utf8_length_from_utf16(start, end), typename string_type::value_type());
+        if (!result.empty())
+            utf8::utf16to8(start, end, &result[0]);
+        else
+            utf8::utf16to8(start, end, std::back_inserter(result));
+        return result;
+    }
+
+    template <typename string_type, typename octet_type>
+    string_type utf8to32_string(const octet_type* start, const octet_type* end)
+    {
+        string_type result(utf8::utf32_length_from_utf8(start, end), typename string_type::value_type());
+        if (!result.empty())
+            utf8::utf8to32(start, end, &result[0]);
+        else
+            utf8::utf8to32(start, end, std::back_inserter(result));
+        return result;
+    }
+
+    template <typename string_type, typename word_type>
+    string_type utf32to8_string(const word_type* start, const word_type* end)
+    {
+        string_type result(utf8::utf8_length_from_utf32(start, end), typename string_type::value_type());
+        if (!result.empty())
+            utf8::utf32to8(start, end, &result[0]);
+        else
+            utf8::utf32to8(start, end, std::back_inserter(result));
+        return result;
+    }
+
+    template <typename string_type, typename octet_type>
+    string_type latin1to8_string(const octet_type* start, const octet_type* end)
+    {
+        std::size_t length = static_cast<std::size_t>(end - start);
+        for (const octet_type* it = start; it != end; ++it)
+            length += static_cast<std::size_t>(utf8::internal::mask8(*it) >> 7);
+        string_type result(length, typename string_type::value_type());
+        if (!result.empty())
+            utf8::latin1to8(start, end, &result[0]);
+        return result;
+    }
+
+    template <typename string_type, typename octet_type>
+    string_type utf8tolatin1_string(const octet_type* start, const octet_type* end)
+    {
+        string_type result(utf8::utf32_length_from_utf8(start, end), typename string_type::value_type());
+        if (!result.empty())
+            utf8::utf8tolatin1(start, end, &result[0]);
+        else
+            utf8::utf8tolatin1(start, end, std::back_inserter(result));
+        return result;
+    }
+} // namespace internal
+
     // The iterator class
     template <typename octet_iterator>
     class iterator {
@@ -347,6 +905,135 @@ namespace utf8
       }
     }; // class iterator
 
+    // Transcodes text that arrives in chunks, such as the reads from a
+    // socket. A code point may straddle chunk boundaries: up to 3 octets of
+    // a UTF-8 sequence, or a lead surrogate, are kept until the rest
+    // arrives, and the rest of each chunk is converted in place, with the
+    // same code as utf8to16 and utf16to8.
+    template <typename from_type, typename to_type>
+    class stream_transcoder;
+
+    template <>
+    class stream_transcoder<char, utfchar16_t> {
+        utfchar8_t pending[3];
+        std::size_t pending_length;
+      public:
+        stream_transcoder() : pending_length(0) {}
+
+        template <typename u16bit_iterator>
+        u16bit_iterator push(const char* data, std::size_t length, u16bit_iterator result)
+        {
+            const char* start = data;
+            const char* const end = data + length;
+            if (pending_length != 0) {
+                // Complete the pending sequence with the first octets of this chunk
+                utfchar8_t sequence[4];
+                std::size_t sequence_length = pending_length;
+                for (std::size_t i = 0; i < pending_length; ++i)
+                    sequence[i] = pending[i];
+                while (sequence_length < 4 && start != end)
+                    sequence[sequence_length++] = static_cast<utfchar8_t>(*start++);
+                const utfchar8_t* it = sequence;
+                utfchar32_t cp = 0;
+                const internal::utf_error err_code = utf8::internal::decode_next(it, it + sequence_length, cp);
+                if (err_code == internal::NOT_ENOUGH_ROOM) {
+                    // Still incomplete, so the whole chunk went into the sequence
+                    for (std::size_t i = pending_length; i < sequence_length; ++i)
+                        pending[i] = sequence[i];
+                    pending_length = sequence_length;
+                    return result;
+                }
+                if (err_code != internal::UTF8_OK) {
+                    // Throws what next() does, as for the whole text at once
+                    it = sequence;
+                    utf8::next(it, it + sequence_length);
+                }
+                result = utf8::append16(cp, result);
+                start = data + ((it - sequence) - static_cast<std::ptrdiff_t>(pending_length));
+                pending_length = 0;
+            }
+            // A sequence cut short by the end of the chunk is kept for the next one
+            const char* cut = end;
+            for (const char* lead = end; lead != start && end - lead < 3; ) {
+                --lead;
+                if (utf8::internal::is_trail(*lead))
+                    continue;
+                const char* it = lead;
+                utfchar32_t cp = 0;
+                if (utf8::internal::decode_next(it, end, cp) == internal::NOT_ENOUGH_ROOM)
+                    cut = lead;
+                break;
+            }
+            try {
+                result = utf8::utf8to16(start, cut, result);
+            }
+            catch (const not_enough_room&) {
+                // The sequence before the kept one runs into it
+                const char* lead = cut;
+                while (lead != start && utf8::internal::is_trail(*--lead))
+                    ;
+                throw invalid_utf8(utf8::internal::mask8(*lead));
+            }
+            for (; cut != end; ++cut)
+                pending[pending_length++] = static_cast<utfchar8_t>(*cut);
+            return result;
+        }
+
+        // Call after the last chunk; throws not_enough_room if the text
+        // ends within a sequence
+        void finish() const
+        {
+            if (pending_length != 0)
+                throw not_enough_room();
+        }
+
+        void reset() { pending_length = 0; }
+    }; // class stream_transcoder<char, utfchar16_t>
+
+    template <>
+    class stream_transcoder<utfchar16_t, char> {
+        utfchar16_t pending;      // a lead surrogate, or 0
+      public:
+        stream_transcoder() : pending(0) {}
+
+        template <typename octet_iterator>
+        octet_iterator push(const utfchar16_t* data, std::size_t length, octet_iterator result)
+        {
+            const utfchar16_t* start = data;
+            const utfchar16_t* end = data + length;
+            if (start == end)
+                return result;
+            if (pending != 0) {
+                const utfchar32_t trail_surrogate = static_cast<utfchar32_t>(utf8::internal::mask16(*start++));
+                if (!utf8::internal::is_trail_surrogate(trail_surrogate))
+                    throw invalid_utf16(static_cast<utfchar16_t>(trail_surrogate));
+                result = utf8::append((static_cast<utfchar32_t>(pending) << 10) + trail_surrogate +
+                                      internal::SURROGATE_OFFSET, result);
+                pending = 0;
+            }
+            // A lead surrogate at the end of the chunk is kept for the next
+            // one, unless it follows another lead surrogate, which utf16to8
+            // reports it for
+            utfchar16_t last = 0;
+            if (start != end && utf8::internal::is_lead_surrogate(utf8::internal::mask16(end[-1])) &&
+                    (end - start == 1 || !utf8::internal::is_lead_surrogate(utf8::internal::mask16(end[-2]))))
+                last = *--end;
+            result = utf8::utf16to8(start, end, result);
+            pending = last;
+            return result;
+        }
+
+        // Call after the last chunk; throws invalid_utf16 if the text ends
+        // with a lead surrogate
+        void finish() const
+        {
+            if (pending != 0)
+                throw invalid_utf16(pending);
+        }
+
+        void reset() { pending = 0; }
+    }; // class stream_transcoder<utfchar16_t, char>
+
 } // namespace utf8
 
 #if UTF_CPP_CPLUSPLUS >= 202002L // C++ 20 or later
@@ -31,6 +31,7 @@ DEALINGS IN THE SOFTWARE.
 #include <iterator>
 #include <cstring>
 #include <string>
+#include <stdint.h>
 
 // Determine the C++ standard version.
 // If the user defines UTF_CPP_CPLUSPLUS, use that.
@@ -68,6 +69,12 @@ namespace utf8
     typedef unsigned short  utfchar16_t;
     typedef unsigned int    utfchar32_t;
 #endif // C++ 11 or later
+} // namespace utf8
+
+#include "simd/dispatch.h"
+
+namespace utf8
+{
 
 // Helper code - not intended to be directly called by the library users. May be changed at any time
 namespace internal
@@ -128,6 +135,12 @@ namespace internal
         return cp < utfchar32_t(0x10000);
     }
 
+    // The number of octets cp takes in UTF-8
+    inline std::size_t utf8_length_of(utfchar32_t cp)
+    {
+        return (cp < 0x80) ? 1 : (cp < 0x800) ? 2 : (cp < 0x10000) ? 3 : 4;
+    }
+
     template <typename octet_iterator>
     int sequence_length(octet_iterator lead_it)
     {
@@ -146,163 +159,127 @@ namespace internal
 
     enum utf_error {UTF8_OK, NOT_ENOUGH_ROOM, INVALID_LEAD, INCOMPLETE_SEQUENCE, OVERLONG_SEQUENCE, INVALID_CODE_POINT};
 
-    /// Helper for get_sequence_x
+    // Table-driven decoder, after Bjoern Hoehrmann's "Flexible and Economical
+    // UTF-8 Decoder". Every octet is mapped to one of 14 classes, and the
+    // state machine takes one transition per octet. The final states are the
+    // utf_error values themselves. Structural errors (a missing or a wrong
+    // trail octet) are reported as soon as they are seen; the states after
+    // an E0, ED, F0, F4 or F5-F7 lead remember an overlong or out of range
+    // value to be reported once the sequence is complete, so the errors are
+    // the same as with the octet-by-octet checks.
+    enum dfa_state {
+        DFA_ACCEPT = UTF8_OK,
+        // INVALID_LEAD, INCOMPLETE_SEQUENCE, OVERLONG_SEQUENCE and
+        // INVALID_CODE_POINT are final too
+        DFA_TRAIL_1 = INVALID_CODE_POINT + 1, DFA_TRAIL_2, DFA_TRAIL_3,
+        DFA_OVERLONG_1, DFA_OVERLONG_2, DFA_INVALID_1, DFA_INVALID_2, DFA_INVALID_3,
+        DFA_AFTER_E0, DFA_AFTER_ED, DFA_AFTER_F0, DFA_AFTER_F4
+    };
+
+    // Classes: 0 ASCII, 1-3 trail octets 80-8F, 90-9F and A0-BF, 4 C0-C1,
+    // 5 C2-DF, 6 E0, 7 other three octet leads, 8 ED, 9 F0, 10 F1-F3, 11 F4,
+    // 12 F5-F7, 13 F8-FF
+    static const unsigned char dfa_octet_classes[256] = {
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+         1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,  1,
+         2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,  2,
+         3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+         3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+         4,  4,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+         5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,  5,
+         6,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  7,  8,  7,  7,
+         9, 10, 10, 10, 11, 12, 12, 12, 13, 13, 13, 13, 13, 13, 13, 13
+    };
+
+    // The payload bits of a lead octet of each class
+    static const unsigned char dfa_lead_masks[14] = {
+        0x7f, 0, 0, 0, 0x1f, 0x1f, 0x0f, 0x0f, 0x0f, 0x07, 0x07, 0x07, 0x07, 0
+    };
+
+    static const unsigned char dfa_trail_counts[14] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 2, 3, 3, 3, 3, 0
+    };
+
+    // Indexed by state and class. The rows of the final states are never used.
+    static const unsigned char dfa_transitions[DFA_AFTER_F4 + 1][14] = {
+        // ASCII  80   90   A0   C0   C2   E0   E1   ED   F0   F1   F4   F5   F8
+        {   0,   2,   2,   2,   9,   6,  14,   7,  15,  16,   8,  17,  13,   2 }, // DFA_ACCEPT: lead octet
+        {   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1 },
+        {   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2 },
+        {   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 },
+        {   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4,   4 },
+        {   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5,   5 },
+        {   3,   0,   0,   0,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_TRAIL_1
+        {   3,   6,   6,   6,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_TRAIL_2
+        {   3,   7,   7,   7,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_TRAIL_3
+        {   3,   4,   4,   4,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_OVERLONG_1
+        {   3,   9,   9,   9,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_OVERLONG_2
+        {   3,   5,   5,   5,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_INVALID_1
+        {   3,  11,  11,  11,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_INVALID_2
+        {   3,  12,  12,  12,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_INVALID_3
+        {   3,   9,   9,   6,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_AFTER_E0
+        {   3,   6,   6,  11,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_AFTER_ED
+        {   3,  10,   7,   7,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }, // DFA_AFTER_F0
+        {   3,   7,  12,  12,   3,   3,   3,   3,   3,   3,   3,   3,   3,   3 }  // DFA_AFTER_F4
+    };
+
+    // One step of the state machine, on the next trail octet
     template <typename octet_iterator>
-    utf_error increase_safely(octet_iterator& it, const octet_iterator end)
+    inline bool dfa_step(octet_iterator& octet_it, octet_iterator end, unsigned int& state, utfchar32_t& cp)
     {
-        if (++it == end)
-            return NOT_ENOUGH_ROOM;
-
-        if (!utf8::internal::is_trail(*it))
-            return INCOMPLETE_SEQUENCE;
-
-        return UTF8_OK;
-    }
-
-    #define UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR(IT, END) {utf_error ret = increase_safely(IT, END); if (ret != UTF8_OK) return ret;}
-
-    /// get_sequence_x functions decode utf-8 sequences of the length x
-    template <typename octet_iterator>
-    utf_error get_sequence_1(octet_iterator& it, octet_iterator end, utfchar32_t& code_point)
-    {
-        if (it == end)
-            return NOT_ENOUGH_ROOM;
-
-        code_point = static_cast<utfchar32_t>(utf8::internal::mask8(*it));
-
-        return UTF8_OK;
-    }
-
-    template <typename octet_iterator>
-    utf_error get_sequence_2(octet_iterator& it, octet_iterator end, utfchar32_t& code_point)
-    {
-        if (it == end)
-            return NOT_ENOUGH_ROOM;
-
-        const utfchar8_t lead = utf8::internal::mask8(*it);
-        code_point = static_cast<utfchar32_t>(lead);
-
-        UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR(it, end)
-
-        const utfchar8_t trail1 = utf8::internal::mask8(*it);
-        code_point = ((code_point << 6) & 0x7ff) + (trail1 & 0x3f);
-
-        if (lead == 0xC0 || lead == 0xC1) {
-            return OVERLONG_SEQUENCE;
-        }
-
-        return UTF8_OK;
+        if (++octet_it == end)
+            return false;
+        const utfchar8_t octet = utf8::internal::mask8(*octet_it);
+        state = dfa_transitions[state][dfa_octet_classes[octet]];
+        cp = (cp << 6) | (octet & 0x3fu);
+        return true;
     }
 
     template <typename octet_iterator>
-    utf_error get_sequence_3(octet_iterator& it, octet_iterator end, utfchar32_t& code_point)
+    utf_error decode_next(octet_iterator& it, octet_iterator end, utfchar32_t& code_point)
     {
         if (it == end)
             return NOT_ENOUGH_ROOM;
 
         const utfchar8_t lead = utf8::internal::mask8(*it);
-        code_point = static_cast<utfchar32_t>(lead);
-
-        UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR(it, end)
-
-        const utfchar8_t trail1 = utf8::internal::mask8(*it);
-        code_point = ((code_point << 12) & 0xffff) + ((trail1 << 6) & 0xfff);
-
-        UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR(it, end)
-
-        const utfchar8_t trail2 = utf8::internal::mask8(*it);
-        code_point = static_cast<utfchar32_t>(code_point + (trail2 & 0x3f));
-
-        if (lead == 0xE0 && trail1 < 0xA0) {
-            return OVERLONG_SEQUENCE;
-        }
-        if (lead == 0xED && trail1 > 0x9F) {
-            return INVALID_CODE_POINT;
-        }
-
-        return UTF8_OK;
-    }
-
-    template <typename octet_iterator>
-    utf_error get_sequence_4(octet_iterator& it, octet_iterator end, utfchar32_t& code_point)
-    {
-        if (it == end)
-           return NOT_ENOUGH_ROOM;
-
-        const utfchar8_t lead = utf8::internal::mask8(*it);
-        code_point = static_cast<utfchar32_t>(lead);
-
-        UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR(it, end)
-
-        const utfchar8_t trail1 = utf8::internal::mask8(*it);
-        code_point = ((code_point << 18) & 0x1fffff) + ((trail1 << 12) & 0x3ffff);
-
-        UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR(it, end)
-
-        const utfchar8_t trail2 = utf8::internal::mask8(*it);
-        code_point = static_cast<utfchar32_t>(code_point + ((trail2 << 6) & 0xfff));
-
-        UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR(it, end)
-
-        const utfchar8_t trail3 = utf8::internal::mask8(*it);
-        code_point = static_cast<utfchar32_t>(code_point + (trail3 & 0x3f));
-
-        if (lead == 0xF0 && trail1 < 0x90) {
-            return OVERLONG_SEQUENCE;
-        }
-        if (lead == 0xF4 && trail1 > 0x8F) {
-            return INVALID_CODE_POINT;
-        }
-        if (lead >= 0xF5) {
-            return INVALID_CODE_POINT;
+        if (lead < 0x80) {
+            code_point = lead;
+            ++it;
+            return UTF8_OK;
         }
 
-        return UTF8_OK;
-    }
-
-    #undef UTF8_CPP_INCREASE_AND_RETURN_ON_ERROR
-
-    template <typename octet_iterator>
-    utf_error decode_next(octet_iterator& it, octet_iterator end, utfchar32_t& cp)
-    {
-        if (it == end)
-            return NOT_ENOUGH_ROOM;
-
-        // Save the original value of it so we can go back in case of failure
-        // Of course, it does not make much sense with i.e. stream iterators
-        octet_iterator original_it = it;
-
-        cp = 0;
-        // Determine the sequence length based on the lead octet
-        const int length = utf8::internal::sequence_length(it);
-
-        // Get trail octets and calculate the code point
-        utf_error err = UTF8_OK;
-        switch (length) {
-            case 0:
-                return INVALID_LEAD;
-            case 1:
-                err = utf8::internal::get_sequence_1(it, end, cp);
-                break;
-            case 2:
-                err = utf8::internal::get_sequence_2(it, end, cp);
-            break;
+        // it only moves on success. The number of trail octets to read is
+        // known from the lead; the state machine checks each of them.
+        octet_iterator octet_it = it;
+        const unsigned int lead_class = dfa_octet_classes[lead];
+        utfchar32_t cp = static_cast<utfchar32_t>(lead & dfa_lead_masks[lead_class]);
+        unsigned int state = dfa_transitions[DFA_ACCEPT][lead_class];
+        switch (dfa_trail_counts[lead_class]) {
             case 3:
-                err = utf8::internal::get_sequence_3(it, end, cp);
-            break;
-            case 4:
-                err = utf8::internal::get_sequence_4(it, end, cp);
-            break;
+                if (!utf8::internal::dfa_step(octet_it, end, state, cp) || state < DFA_TRAIL_1)
+                    break;
+                // fall through
+            case 2:
+                if (!utf8::internal::dfa_step(octet_it, end, state, cp) || state < DFA_TRAIL_1)
+                    break;
+                // fall through
+            case 1:
+                utf8::internal::dfa_step(octet_it, end, state, cp);
         }
 
-        if (err != UTF8_OK) {
-        // Failure branch - restore the original value of the iterator
-            it = original_it;
-            cp = 0;
-            return err;
+        if (state != DFA_ACCEPT) {
+            code_point = 0;
+            return (state >= DFA_TRAIL_1) ? NOT_ENOUGH_ROOM : static_cast<utf_error>(state);
         }
-
-        it++; // Successfully parsed the sequence, advance the iterator
+        it = ++octet_it;
+        code_point = cp;
         return UTF8_OK;
     }
 
@@ -413,6 +390,300 @@ namespace internal
         }
    }
 
+    // Word-at-a-time ASCII scanning: eight octets are all ASCII if none of them
+    // has the high bit set. Returns the first non-ASCII position of [it, end).
+    // Only contiguous byte input is scanned; other iterators get an empty run.
+    template <typename octet_iterator>
+    inline octet_iterator skip_ascii(octet_iterator it, octet_iterator)
+    {
+        return it;
+    }
+
+    inline const char* skip_ascii(const char* it, const char* end)
+    {
+        const uint64_t high_bits = 0x80808080u | (static_cast<uint64_t>(0x80808080u) << 32);
+        // Don't bother loading a word in the middle of non-ASCII text
+        if (it == end || utf8::internal::mask8(*it) >= 0x80)
+            return it;
+        while (end - it >= 8) {
+            uint64_t word;
+            std::memcpy(&word, it, sizeof(word));
+            if (word & high_bits)
+                break;
+            it += 8;
+        }
+        while (it != end && utf8::internal::mask8(*it) < 0x80)
+            ++it;
+        return it;
+    }
+
+    template <typename octet_type>
+    inline octet_type* skip_ascii(octet_type* it, octet_type* end)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return it;
+        const char* first = reinterpret_cast<const char*>(it);
+        return it + (utf8::internal::skip_ascii(first, first + (end - it)) - first);
+    }
+
+    template <typename octet_iterator>
+    octet_iterator find_invalid(octet_iterator start, octet_iterator end)
+    {
+        octet_iterator result = start;
+        while (result != end) {
+            utf8::internal::utf_error err_code = utf8::internal::validate_next(result, end);
+            if (err_code != internal::UTF8_OK)
+                return result;
+        }
+        return result;
+    }
+
+    // Contiguous input. The vectorized validator skips over the blocks it can
+    // vouch for, and validate_next pins down the exact position of the error
+    // within the block where it gave up. Without a vectorized validator, ASCII
+    // runs are consumed a word at a time, and validate_next only gets to see
+    // the non-ASCII sequences.
+    inline const char* find_invalid(const char* start, const char* end)
+    {
+        const char* result = start;
+        const utf8::internal::simd::validate_kernel validate = utf8::internal::simd::active().validate;
+        if (validate) {
+            // Must exceed a vector block plus the three octets resync() may step back
+            const std::ptrdiff_t scalar_window = 80;
+            while (result != end) {
+                result = validate(result, end);
+                const char* const window_end = (end - result > scalar_window) ? result + scalar_window : end;
+                while (result < window_end)
+                    if (utf8::internal::validate_next(result, end) != UTF8_OK)
+                        return result;
+            }
+            return result;
+        }
+        while (result != end) {
+            result = utf8::internal::skip_ascii(result, end);
+            if (result != end && utf8::internal::validate_next(result, end) != UTF8_OK)
+                return result;
+        }
+        return result;
+    }
+
+    // Any other pointer to byte-sized code units takes the contiguous path too
+    template <typename octet_type>
+    octet_type* find_invalid(octet_type* start, octet_type* end)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return utf8::internal::find_invalid<octet_type*>(start, end);
+        const char* first = reinterpret_cast<const char*>(start);
+        return start + (utf8::internal::find_invalid(first, first + (end - start)) - first);
+    }
+
+    // The valid run at the start of contiguous input, for algorithms that can
+    // handle it in bulk; other iterators get an empty run. The run ends
+    // within a cache-sized chunk, so that the algorithm gets to the octets
+    // while the validator has them in the cache; the caller goes on from
+    // the end of the run as it would from an invalid sequence.
+    template <typename octet_iterator>
+    inline octet_iterator skip_valid(octet_iterator start, octet_iterator)
+    {
+        return start;
+    }
+
+    template <typename octet_type>
+    inline octet_type* skip_valid(octet_type* start, octet_type* end)
+    {
+        const std::ptrdiff_t chunk = 16384;
+        return utf8::internal::find_invalid(start, (end - start > chunk) ? start + chunk : end);
+    }
+
+    // Copies a run of octets to the output, in one block when both sides are
+    // contiguous
+    template <typename octet_iterator, typename output_iterator>
+    inline output_iterator copy_run(octet_iterator first, octet_iterator last, output_iterator out)
+    {
+        for (; first != last; ++first)
+            *out++ = *first;
+        return out;
+    }
+
+    template <typename octet_type>
+    inline octet_type* copy_run(const octet_type* first, const octet_type* last, octet_type* out)
+    {
+        std::memcpy(out, first, static_cast<std::size_t>(last - first) * sizeof(octet_type));
+        return out + (last - first);
+    }
+
+    template <typename octet_type>
+    inline octet_type* copy_run(octet_type* first, octet_type* last, octet_type* out)
+    {
+        return utf8::internal::copy_run(static_cast<const octet_type*>(first), static_cast<const octet_type*>(last), out);
+    }
+
+    // Number of code points in a valid range: every octet but the trail ones
+    // starts a code point
+    template <typename octet_iterator>
+    typename std::iterator_traits<octet_iterator>::difference_type
+    count_code_points(octet_iterator first, octet_iterator last)
+    {
+        typename std::iterator_traits<octet_iterator>::difference_type count = 0;
+        for (; first != last; ++first)
+            if (!utf8::internal::is_trail(*first))
+                ++count;
+        return count;
+    }
+
+    // Contiguous input: whole blocks go to the vectorized counter, if there
+    // is one, and the rest is counted a word at a time
+    inline std::ptrdiff_t count_code_points(const char* first, const char* last)
+    {
+        std::ptrdiff_t count = 0;
+        const utf8::internal::simd::utf8_count_kernel kernel = utf8::internal::simd::active().utf32_length_from_utf8;
+        if (kernel)
+            count += static_cast<std::ptrdiff_t>(kernel(first, last));
+        const uint64_t high_bits = 0x80808080u | (static_cast<uint64_t>(0x80808080u) << 32);
+        const uint64_t low_bits = 0x01010101u | (static_cast<uint64_t>(0x01010101u) << 32);
+        count += last - first;
+        while (last - first >= 8) {
+            uint64_t word;
+            std::memcpy(&word, first, sizeof(word));
+            // Trail octets have the high bit set and the next one clear; the
+            // multiplication sums up the flags in the top byte
+            const uint64_t trail = word & ~(word << 1) & high_bits;
+            count -= static_cast<std::ptrdiff_t>(((trail >> 7) * low_bits) >> 56);
+            first += 8;
+        }
+        for (; first != last; ++first)
+            if (utf8::internal::is_trail(*first))
+                --count;
+        return count;
+    }
+
+    template <typename octet_type>
+    std::ptrdiff_t count_code_points(octet_type* first, octet_type* last)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return utf8::internal::count_code_points<octet_type*>(first, last);
+        const char* start = reinterpret_cast<const char*>(first);
+        return utf8::internal::count_code_points(start, start + (last - first));
+    }
+
+    // Moving over many code points of contiguous input: any k octets hold
+    // at most k code points, so the next n - passed octets can be taken in
+    // bulk without going past the n-th code point, a cache-sized chunk at a
+    // time. Only what the validator vouches for is counted; the span is cut
+    // at the end of its last whole code point, or at an invalid sequence.
+    // Fewer than a block of code points are left for the caller to step over,
+    // and so is whatever is not valid, to be stepped over, or reported, one
+    // code point at a time as it would be otherwise.
+    inline std::ptrdiff_t skip_span(std::ptrdiff_t code_points, std::ptrdiff_t available)
+    {
+        const std::ptrdiff_t chunk = 16384;
+        const std::ptrdiff_t span = (code_points < chunk) ? code_points : chunk;
+        return (span < available) ? span : available;
+    }
+
+    template <typename octet_type>
+    bool skip_valid_span(octet_type*& it, octet_type* span_end, std::ptrdiff_t& passed)
+    {
+        octet_type* const valid_end = utf8::internal::find_invalid(it, span_end);
+        if (valid_end == it)
+            return false;
+        passed += utf8::internal::count_code_points(it, valid_end);
+        it = valid_end;
+        return true;
+    }
+
+    // Backward, the span starts with its first lead octet, which is at most
+    // three octets in; unless the span starts the input, which is for the
+    // validator to check
+    template <typename octet_type>
+    bool skip_valid_span_back(octet_type* span_start, octet_type*& it, bool at_start, std::ptrdiff_t& passed)
+    {
+        if (!at_start) {
+            for (int i = 0; i < 3 && utf8::internal::is_trail(*span_start); ++i)
+                ++span_start;
+            if (utf8::internal::is_trail(*span_start))
+                return false;
+        }
+        if (utf8::internal::find_invalid(span_start, it) != it)
+            return false;
+        passed += utf8::internal::count_code_points(span_start, it);
+        it = span_start;
+        return true;
+    }
+
+    // Unchecked input: the n code points are there, at least an octet each,
+    // so the octets counted are ones that stepping over them would read too
+    template <typename octet_iterator>
+    inline std::ptrdiff_t skip_code_points(octet_iterator&, std::ptrdiff_t)
+    {
+        return 0;
+    }
+
+    template <typename octet_iterator>
+    inline std::ptrdiff_t skip_code_points_back(octet_iterator&, std::ptrdiff_t)
+    {
+        return 0;
+    }
+
+    template <typename octet_type>
+    std::ptrdiff_t skip_code_points(octet_type*& it, std::ptrdiff_t n)
+    {
+        const std::ptrdiff_t block = 16;
+        std::ptrdiff_t passed = 0;
+        while (n - passed >= block)
+            if (!utf8::internal::skip_valid_span(it, it + utf8::internal::skip_span(n - passed, n - passed), passed))
+                break;
+        return passed;
+    }
+
+    template <typename octet_type>
+    std::ptrdiff_t skip_code_points_back(octet_type*& it, std::ptrdiff_t n)
+    {
+        const std::ptrdiff_t block = 16;
+        std::ptrdiff_t passed = 0;
+        while (n - passed >= block)
+            if (!utf8::internal::skip_valid_span_back(it - utf8::internal::skip_span(n - passed, n - passed), it, false, passed))
+                break;
+        return passed;
+    }
+
+    // Checked input: the spans end at the limit of the input as well
+    template <typename octet_iterator>
+    inline std::ptrdiff_t skip_valid_code_points(octet_iterator&, octet_iterator, std::ptrdiff_t)
+    {
+        return 0;
+    }
+
+    template <typename octet_iterator>
+    inline std::ptrdiff_t skip_valid_code_points_back(octet_iterator, octet_iterator&, std::ptrdiff_t)
+    {
+        return 0;
+    }
+
+    template <typename octet_type>
+    std::ptrdiff_t skip_valid_code_points(octet_type*& it, octet_type* end, std::ptrdiff_t n)
+    {
+        const std::ptrdiff_t block = 16;
+        std::ptrdiff_t passed = 0;
+        while (n - passed >= block && it != end)
+            if (!utf8::internal::skip_valid_span(it, it + utf8::internal::skip_span(n - passed, end - it), passed))
+                break;
+        return passed;
+    }
+
+    template <typename octet_type>
+    std::ptrdiff_t skip_valid_code_points_back(octet_type* start, octet_type*& it, std::ptrdiff_t n)
+    {
+        const std::ptrdiff_t block = 16;
+        std::ptrdiff_t passed = 0;
+        while (n - passed >= block && it != start) {
+            octet_type* const span_start = it - utf8::internal::skip_span(n - passed, it - start);
+            if (!utf8::internal::skip_valid_span_back(span_start, it, span_start == start, passed))
+                break;
+        }
+        return passed;
+    }
+
     template <typename word_iterator>
     utf_error validate_next16(word_iterator& it, word_iterator end, utfchar32_t& code_point)
     {
@@ -535,6 +806,379 @@ namespace internal
         return append16<word_iterator, utfchar16_t>(cp, result);
     }
 
+    // Copies octets produced by a vectorized kernel to the output, using the
+    // same octet_type deduction as append()
+    template <typename octet_iterator, typename octet_type>
+    octet_iterator copy_octets(const char* first, const char* last, octet_iterator result) {
+        for (; first != last; ++first)
+            *(result++) = static_cast<octet_type>(*first);
+        return result;
+    }
+
+    inline char* copy_octets(const char* first, const char* last, char* result) {
+        std::memcpy(result, first, static_cast<std::size_t>(last - first));
+        return result + (last - first);
+    }
+
+    template<typename container_type>
+    std::back_insert_iterator<container_type> copy_octets
+            (const char* first, const char* last, std::back_insert_iterator<container_type> result) {
+        return copy_octets<std::back_insert_iterator<container_type>,
+            typename container_type::value_type>(first, last, result);
+    }
+
+    template <typename octet_iterator>
+    octet_iterator copy_octets(const char* first, const char* last, octet_iterator result) {
+        return copy_octets<octet_iterator, utfchar8_t>(first, last, result);
+    }
+
+    // Copies code units produced by a vectorized kernel to the output; octets
+    // go through copy_octets() for the octet_type deduction
+    template <typename unit_type, typename output_iterator>
+    output_iterator copy_units(const unit_type* first, const unit_type* last, output_iterator result) {
+        for (; first != last; ++first)
+            *(result++) = *first;
+        return result;
+    }
+
+    template <typename octet_iterator>
+    octet_iterator copy_units(const char* first, const char* last, octet_iterator result) {
+        return utf8::internal::copy_octets(first, last, result);
+    }
+
+    // Plain memory copies for pointers to code units of the same size
+    template <typename word_type>
+    word_type* copy_units(const uint16_t* first, const uint16_t* last, word_type* result) {
+        if (sizeof(word_type) != sizeof(uint16_t)) {
+            for (; first != last; ++first)
+                *(result++) = static_cast<word_type>(*first);
+            return result;
+        }
+        std::memcpy(result, first, static_cast<std::size_t>(last - first) * sizeof(uint16_t));
+        return result + (last - first);
+    }
+
+    template <typename word_type>
+    word_type* copy_units(const uint32_t* first, const uint32_t* last, word_type* result) {
+        if (sizeof(word_type) != sizeof(uint32_t)) {
+            for (; first != last; ++first)
+                *(result++) = static_cast<word_type>(*first);
+            return result;
+        }
+        std::memcpy(result, first, static_cast<std::size_t>(last - first) * sizeof(uint32_t));
+        return result + (last - first);
+    }
+
+    // Block-wise transcoding of contiguous input. The kernels convert as much
+    // of the input as they can vouch for into a buffer on the stack, which is
+    // then copied to result, so any output iterator works. They always stop
+    // on a code point boundary; the callers take it from there with the
+    // scalar code, which also reports any errors.
+    template <typename in_type, typename out_type, typename output_iterator>
+    const in_type* transcode_blocks(void (*kernel)(const in_type*&, const in_type*, out_type*&, out_type*),
+                                    const in_type* start, const in_type* end, output_iterator& result)
+    {
+        if (!kernel)
+            return start;
+        const std::ptrdiff_t buffer_size = 256;
+        out_type buffer[buffer_size];
+        const in_type* it = start;
+        for (;;) {
+            const in_type* const block_start = it;
+            out_type* out = buffer;
+            kernel(it, end, out, buffer + buffer_size);
+            result = utf8::internal::copy_units(buffer, out, result);
+            if (it == block_start)
+                return it;
+        }
+    }
+
+    // The same, into a buffer that ends at result_end
+    template <typename in_type, typename out_type, typename word_type>
+    const in_type* transcode_blocks(void (*kernel)(const in_type*&, const in_type*, out_type*&, out_type*),
+                                    const in_type* start, const in_type* end, word_type*& result, word_type* result_end)
+    {
+        if (!kernel)
+            return start;
+        const std::ptrdiff_t buffer_size = 256;
+        out_type buffer[buffer_size];
+        const in_type* it = start;
+        for (;;) {
+            const in_type* const block_start = it;
+            out_type* out = buffer;
+            const std::ptrdiff_t room = result_end - result;
+            kernel(it, end, out, buffer + (room < buffer_size ? room : buffer_size));
+            result = utf8::internal::copy_units(buffer, out, result);
+            if (it == block_start)
+                return it;
+        }
+    }
+
+    // The entry points for the algorithms; other iterators are returned unchanged
+    template <typename octet_iterator, typename u16bit_iterator>
+    inline octet_iterator utf8to16_blocks(octet_iterator start, octet_iterator, u16bit_iterator&)
+    {
+        return start;
+    }
+
+    template <typename octet_type, typename u16bit_iterator>
+    octet_type* utf8to16_blocks(octet_type* start, octet_type* end, u16bit_iterator& result)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return start;
+        const char* const first = reinterpret_cast<const char*>(start);
+        return start + (utf8::internal::transcode_blocks(utf8::internal::simd::active().utf8_to_utf16,
+                                                         first, first + (end - start), result) - first);
+    }
+
+    template <typename u16bit_iterator, typename octet_iterator>
+    inline u16bit_iterator utf16to8_blocks(u16bit_iterator start, u16bit_iterator, octet_iterator&)
+    {
+        return start;
+    }
+
+    template <typename word_type, typename octet_iterator>
+    word_type* utf16to8_blocks(word_type* start, word_type* end, octet_iterator& result)
+    {
+        if (sizeof(word_type) != sizeof(utfchar16_t))
+            return start;
+        const uint16_t* const first = reinterpret_cast<const uint16_t*>(start);
+        return start + (utf8::internal::transcode_blocks(utf8::internal::simd::active().utf16_to_utf8,
+                                                         first, first + (end - start), result) - first);
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator>
+    inline octet_iterator utf8to32_blocks(octet_iterator start, octet_iterator, u32bit_iterator&)
+    {
+        return start;
+    }
+
+    template <typename octet_type, typename u32bit_iterator>
+    octet_type* utf8to32_blocks(octet_type* start, octet_type* end, u32bit_iterator& result)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return start;
+        const char* const first = reinterpret_cast<const char*>(start);
+        return start + (utf8::internal::transcode_blocks(utf8::internal::simd::active().utf8_to_utf32,
+                                                         first, first + (end - start), result) - first);
+    }
+
+    template <typename u32bit_iterator, typename octet_iterator>
+    inline u32bit_iterator utf32to8_blocks(u32bit_iterator start, u32bit_iterator, octet_iterator&)
+    {
+        return start;
+    }
+
+    template <typename word_type, typename octet_iterator>
+    word_type* utf32to8_blocks(word_type* start, word_type* end, octet_iterator& result)
+    {
+        if (sizeof(word_type) != sizeof(utfchar32_t))
+            return start;
+        const uint32_t* const first = reinterpret_cast<const uint32_t*>(start);
+        return start + (utf8::internal::transcode_blocks(utf8::internal::simd::active().utf32_to_utf8,
+                                                         first, first + (end - start), result) - first);
+    }
+
+    template <typename octet_iterator, typename output_iterator>
+    inline octet_iterator latin1to8_blocks(octet_iterator start, octet_iterator, output_iterator&)
+    {
+        return start;
+    }
+
+    template <typename octet_type, typename output_iterator>
+    octet_type* latin1to8_blocks(octet_type* start, octet_type* end, output_iterator& result)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return start;
+        const char* const first = reinterpret_cast<const char*>(start);
+        return start + (utf8::internal::transcode_blocks(utf8::internal::simd::active().latin1_to_utf8,
+                                                         first, first + (end - start), result) - first);
+    }
+
+    template <typename octet_iterator, typename output_iterator>
+    inline octet_iterator utf8tolatin1_blocks(octet_iterator start, octet_iterator, output_iterator&)
+    {
+        return start;
+    }
+
+    template <typename octet_type, typename output_iterator>
+    octet_type* utf8tolatin1_blocks(octet_type* start, octet_type* end, output_iterator& result)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return start;
+        const char* const first = reinterpret_cast<const char*>(start);
+        return start + (utf8::internal::transcode_blocks(utf8::internal::simd::active().utf8_to_latin1,
+                                                         first, first + (end - start), result) - first);
+    }
+
+    // Code units stored as bytes in a given order
+    enum byte_order {big_endian, little_endian};
+
+    inline byte_order native_byte_order()
+    {
+        const uint16_t one = 1;
+        unsigned char first;
+        std::memcpy(&first, &one, 1);
+        return first ? little_endian : big_endian;
+    }
+
+    inline uint16_t swap_bytes(uint16_t unit)
+    {
+        return static_cast<uint16_t>((unit >> 8) | (unit << 8));
+    }
+
+    inline uint32_t swap_bytes(uint32_t unit)
+    {
+        return (unit >> 24) | ((unit >> 8) & 0xff00) | ((unit << 8) & 0xff0000) | (unit << 24);
+    }
+
+    template <byte_order order, typename unit_type, typename byte_iterator>
+    byte_iterator write_unit(utfchar32_t unit, byte_iterator result)
+    {
+        char bytes[sizeof(unit_type)];
+        for (std::size_t i = 0; i < sizeof(unit_type); ++i) {
+            const std::size_t shift = 8 * ((order == big_endian) ? sizeof(unit_type) - 1 - i : i);
+            bytes[i] = static_cast<char>((unit >> shift) & 0xff);
+        }
+        return utf8::internal::copy_octets(bytes, bytes + sizeof(unit_type), result);
+    }
+
+    // Block-wise transcoding of code units stored as bytes: they go through
+    // the same kernels as native code units, a block at a time through a
+    // buffer on the stack, where the bytes are swapped in place if the
+    // order is not the native one.
+    inline void swap_units(uint16_t* units, uint16_t* end)
+    {
+        if (const utf8::internal::simd::swap_bytes16_kernel kernel = utf8::internal::simd::active().swap_bytes16)
+            kernel(units, end);
+        for (; units != end; ++units)
+            *units = utf8::internal::swap_bytes(*units);
+    }
+
+    inline void swap_units(uint32_t* units, uint32_t* end)
+    {
+        if (const utf8::internal::simd::swap_bytes32_kernel kernel = utf8::internal::simd::active().swap_bytes32)
+            kernel(units, end);
+        for (; units != end; ++units)
+            *units = utf8::internal::swap_bytes(*units);
+    }
+
+    template <byte_order order, typename unit_type>
+    void load_units(const char* bytes, std::size_t count, unit_type* units)
+    {
+        std::memcpy(units, bytes, count * sizeof(unit_type));
+        if (order != utf8::internal::native_byte_order())
+            utf8::internal::swap_units(units, units + count);
+    }
+
+    template <byte_order order, typename unit_type, typename octet_iterator>
+    const char* transcode_units_to8(void (*kernel)(const unit_type*&, const unit_type*, char*&, char*),
+                                    const char* start, const char* end, octet_iterator& result)
+    {
+        if (!kernel)
+            return start;
+        const std::ptrdiff_t buffer_size = 256;
+        unit_type units[buffer_size];
+        const char* it = start;
+        for (;;) {
+            const std::ptrdiff_t available = (end - it) / static_cast<std::ptrdiff_t>(sizeof(unit_type));
+            const std::size_t count = static_cast<std::size_t>(available < buffer_size ? available : buffer_size);
+            utf8::internal::load_units<order>(it, count, units);
+            const unit_type* const converted = utf8::internal::transcode_blocks(kernel, units, units + count, result);
+            if (converted == units)
+                return it;
+            // The kernel stops short of the end of the buffer; the rest is loaded again
+            it += (converted - units) * static_cast<std::ptrdiff_t>(sizeof(unit_type));
+        }
+    }
+
+    template <byte_order order, typename unit_type, typename byte_iterator>
+    const char* transcode_8_to_units(void (*kernel)(const char*&, const char*, unit_type*&, unit_type*),
+                                     const char* start, const char* end, byte_iterator& result)
+    {
+        if (!kernel)
+            return start;
+        const std::ptrdiff_t buffer_size = 256;
+        unit_type buffer[buffer_size];
+        const char* it = start;
+        for (;;) {
+            const char* const block_start = it;
+            unit_type* out = buffer;
+            kernel(it, end, out, buffer + buffer_size);
+            if (order != utf8::internal::native_byte_order())
+                utf8::internal::swap_units(buffer, out);
+            const char* const bytes = reinterpret_cast<const char*>(buffer);
+            result = utf8::internal::copy_octets(bytes, reinterpret_cast<const char*>(out), result);
+            if (it == block_start)
+                return it;
+        }
+    }
+
+    // The entry points; other iterators are returned unchanged
+    template <byte_order order, typename unit_type, typename byte_iterator, typename octet_iterator>
+    inline byte_iterator units_to8_blocks(byte_iterator start, byte_iterator, octet_iterator&)
+    {
+        return start;
+    }
+
+    template <byte_order order, typename unit_type, typename byte_type, typename octet_iterator>
+    byte_type* units_to8_blocks(byte_type* start, byte_type* end, octet_iterator& result)
+    {
+        if (sizeof(byte_type) != sizeof(char))
+            return start;
+        const char* const first = reinterpret_cast<const char*>(start);
+        const char* converted;
+        if (sizeof(unit_type) == sizeof(uint16_t))
+            converted = utf8::internal::transcode_units_to8<order>(utf8::internal::simd::active().utf16_to_utf8,
+                                                                   first, first + (end - start), result);
+        else
+            converted = utf8::internal::transcode_units_to8<order>(utf8::internal::simd::active().utf32_to_utf8,
+                                                                   first, first + (end - start), result);
+        return start + (converted - first);
+    }
+
+    template <byte_order order, typename unit_type, typename octet_iterator, typename byte_iterator>
+    inline octet_iterator utf8_to_units_blocks(octet_iterator start, octet_iterator, byte_iterator&)
+    {
+        return start;
+    }
+
+    template <byte_order order, typename unit_type, typename octet_type, typename byte_iterator>
+    octet_type* utf8_to_units_blocks(octet_type* start, octet_type* end, byte_iterator& result)
+    {
+        if (sizeof(octet_type) != sizeof(char))
+            return start;
+        const char* const first = reinterpret_cast<const char*>(start);
+        const char* converted;
+        if (sizeof(unit_type) == sizeof(uint16_t))
+            converted = utf8::internal::transcode_8_to_units<order>(utf8::internal::simd::active().utf8_to_utf16,
+                                                                    first, first + (end - start), result);
+        else
+            converted = utf8::internal::transcode_8_to_units<order>(utf8::internal::simd::active().utf8_to_utf32,
+                                                                    first, first + (end - start), result);
+        return start + (converted - first);
+    }
+
+    // Output lengths: the kernels count whole blocks of contiguous input;
+    // other iterators are returned unchanged
+    template <typename iterator, typename count_kernel>
+    inline iterator count_blocks(count_kernel, iterator start, iterator, std::size_t&)
+    {
+        return start;
+    }
+
+    template <typename unit_type, typename in_type>
+    unit_type* count_blocks(std::size_t (*kernel)(const in_type*&, const in_type*),
+                            unit_type* start, unit_type* end, std::size_t& length)
+    {
+        if (!kernel || sizeof(unit_type) != sizeof(in_type))
+            return start;
+        const in_type* const first = reinterpret_cast<const in_type*>(start);
+        const in_type* it = first;
+        length += kernel(it, first + (end - start));
+        return start + (it - first);
+    }
+
 } // namespace internal
 
     /// The library API - functions intended to be called by the users
@@ -542,16 +1186,17 @@ namespace internal
     // Byte order mark
     const utfchar8_t bom[] = {0xef, 0xbb, 0xbf};
 
+    // The set of vectorized kernels picked for this CPU: "avx512-vbmi2",
+    // "avx512", "avx2", "sse4.2" or "scalar"
+    inline const char* active_implementation()
+    {
+        return utf8::internal::simd::active().name;
+    }
+
     template <typename octet_iterator>
     octet_iterator find_invalid(octet_iterator start, octet_iterator end)
     {
-        octet_iterator result = start;
-        while (result != end) {
-            utf8::internal::utf_error err_code = utf8::internal::validate_next(result, end);
-            if (err_code != internal::UTF8_OK)
-                return result;
-        }
-        return result;
+        return utf8::internal::find_invalid(start, end);
     }
 
     inline const char* find_invalid(const char* str)
@@ -562,8 +1207,8 @@ namespace internal
 
     inline std::size_t find_invalid(const std::string& s)
     {
-        std::string::const_iterator invalid = find_invalid(s.begin(), s.end());
-        return (invalid == s.end()) ? std::string::npos : static_cast<std::size_t>(invalid - s.begin());
+        const char* invalid = utf8::internal::find_invalid(s.data(), s.data() + s.size());
+        return (invalid == s.data() + s.size()) ? std::string::npos : static_cast<std::size_t>(invalid - s.data());
     }
 
     template <typename octet_iterator>
@@ -579,11 +1224,491 @@ namespace internal
 
     inline bool is_valid(const std::string& s)
     {
-        return is_valid(s.begin(), s.end());
+        return (utf8::find_invalid(s) == std::string::npos);
+    }
+
+    // Validates text that arrives in chunks, such as network packets. A
+    // sequence may straddle chunk boundaries: up to 3 octets of it are kept
+    // until the rest arrives, and nothing else is copied.
+    class stream_validator {
+        utfchar8_t pending[3];
+        std::size_t pending_length;
+        std::size_t offset;       // octets fed so far
+        std::size_t first_error;  // std::string::npos while the input is valid
+      public:
+        stream_validator() : pending_length(0), offset(0), first_error(std::string::npos) {}
+
+        // Returns false once an invalid sequence is found; the remaining
+        // input is ignored until reset() is called.
+        bool feed(const char* data, std::size_t length)
+        {
+            if (first_error != std::string::npos)
+                return false;
+            const char* start = data;
+            const char* end = data + length;
+            if (pending_length != 0) {
+                // Complete the pending sequence with the first octets of this chunk
+                utfchar8_t sequence[4];
+                std::size_t sequence_length = pending_length;
+                for (std::size_t i = 0; i < pending_length; ++i)
+                    sequence[i] = pending[i];
+                while (sequence_length < 4 && start != end)
+                    sequence[sequence_length++] = static_cast<utfchar8_t>(*start++);
+                utfchar8_t* it = sequence;
+                const utf8::internal::utf_error err_code = utf8::internal::validate_next(it, sequence + sequence_length);
+                if (err_code == utf8::internal::NOT_ENOUGH_ROOM) {
+                    // Still incomplete, so the whole chunk went into the sequence
+                    for (std::size_t i = pending_length; i < sequence_length; ++i)
+                        pending[i] = sequence[i];
+                    pending_length = sequence_length;
+                    offset += length;
+                    return true;
+                }
+                if (err_code != utf8::internal::UTF8_OK) {
+                    first_error = offset - pending_length;
+                    return false;
+                }
+                start = data + ((it - sequence) - static_cast<std::ptrdiff_t>(pending_length));
+                pending_length = 0;
+            }
+            const char* invalid = utf8::internal::find_invalid(start, end);
+            if (invalid != end) {
+                const char* it = invalid;
+                if (utf8::internal::validate_next(it, end) != utf8::internal::NOT_ENOUGH_ROOM) {
+                    first_error = offset + static_cast<std::size_t>(invalid - data);
+                    return false;
+                }
+                // A sequence cut short by the end of the chunk
+                for (it = invalid; it != end; ++it)
+                    pending[pending_length++] = static_cast<utfchar8_t>(*it);
+            }
+            offset += length;
+            return true;
+        }
+
+        // Call after the last chunk; an incomplete sequence at the end of
+        // the input is an error.
+        bool finish()
+        {
+            if (first_error == std::string::npos && pending_length != 0)
+                first_error = offset - pending_length;
+            return (first_error == std::string::npos);
+        }
+
+        // Offset of the first invalid sequence from the start of the input,
+        // or std::string::npos if none was found
+        std::size_t error_offset() const { return first_error; }
+
+        void reset()
+        {
+            pending_length = 0;
+            offset = 0;
+            first_error = std::string::npos;
+        }
+    }; // class stream_validator
+
+    // An invalid sequence: the octets replace_invalid replaces with a single
+    // replacement mark
+    struct invalid_sequence {
+        std::size_t offset;               // from the start of the input
+        std::size_t length;               // in octets
+        utf8::internal::utf_error error;  // as reported by validate_next
+    };
+
+namespace internal
+{
+    template <typename output_iterator>
+    struct invalid_sequence_writer {
+        output_iterator out;
+        explicit invalid_sequence_writer(output_iterator result) : out(result) {}
+        void operator () (const invalid_sequence& sequence) { *out++ = sequence; }
+    };
+} // namespace internal
+
+    // Calls f for each invalid sequence, up to max_errors of them, in a
+    // single pass over the input
+    template <typename octet_iterator, typename function>
+    function for_each_invalid(octet_iterator start, octet_iterator end, function f,
+                              std::size_t max_errors = static_cast<std::size_t>(-1))
+    {
+        std::size_t offset = 0;
+        for (std::size_t found = 0; found < max_errors; ++found) {
+            octet_iterator invalid = utf8::internal::find_invalid(start, end);
+            offset += static_cast<std::size_t>(std::distance(start, invalid));
+            if (invalid == end)
+                break;
+            start = invalid;
+            invalid_sequence sequence;
+            sequence.offset = offset;
+            sequence.error = utf8::internal::validate_next(start, end);
+            // validate_next leaves start at the invalid sequence
+            ++start;
+            std::size_t length = 1;
+            if (sequence.error != utf8::internal::INVALID_LEAD) {
+                for (; start != end && (sequence.error == utf8::internal::NOT_ENOUGH_ROOM || utf8::internal::is_trail(*start)); ++start)
+                    ++length;
+            }
+            sequence.length = length;
+            offset += length;
+            f(sequence);
+        }
+        return f;
+    }
+
+    // Writes an invalid_sequence for each invalid sequence, up to max_errors
+    // of them, to out
+    template <typename octet_iterator, typename output_iterator>
+    output_iterator find_all_invalid(octet_iterator start, octet_iterator end, output_iterator out,
+                                     std::size_t max_errors = static_cast<std::size_t>(-1))
+    {
+        return utf8::for_each_invalid(start, end, utf8::internal::invalid_sequence_writer<output_iterator>(out), max_errors).out;
     }
 
 
 
+    // Output lengths, for sizing the result of a conversion up front. They
+    // are exact for valid input and do not validate it; for invalid input,
+    // they are never less than what the checked conversions write before
+    // they throw.
+    template <typename octet_iterator>
+    std::size_t utf16_length_from_utf8(octet_iterator start, octet_iterator end)
+    {
+        std::size_t length = 0;
+        start = utf8::internal::count_blocks(utf8::internal::simd::active().utf16_length_from_utf8, start, end, length);
+        for (; start != end; ++start) {
+            const utfchar8_t octet = utf8::internal::mask8(*start);
+            if (!utf8::internal::is_trail(octet))
+                length += (octet >= 0xf0) ? 2 : 1;
+        }
+        return length;
+    }
+
+    template <typename octet_iterator>
+    std::size_t utf32_length_from_utf8(octet_iterator start, octet_iterator end)
+    {
+        std::size_t length = 0;
+        start = utf8::internal::count_blocks(utf8::internal::simd::active().utf32_length_from_utf8, start, end, length);
+        for (; start != end; ++start)
+            if (!utf8::internal::is_trail(*start))
+                ++length;
+        return length;
+    }
+
+    template <typename u16bit_iterator>
+    std::size_t utf8_length_from_utf16(u16bit_iterator start, u16bit_iterator end)
+    {
+        std::size_t length = 0;
+        start = utf8::internal::count_blocks(utf8::internal::simd::active().utf8_length_from_utf16, start, end, length);
+        for (; start != end; ++start) {
+            const utfchar16_t unit = utf8::internal::mask16(*start);
+            // A surrogate pair encodes to four octets
+            if (unit < 0x80)
+                length += 1;
+            else if (unit < 0x800 || utf8::internal::is_surrogate(unit))
+                length += 2;
+            else
+                length += 3;
+        }
+        return length;
+    }
+
+    template <typename u32bit_iterator>
+    std::size_t utf8_length_from_utf32(u32bit_iterator start, u32bit_iterator end)
+    {
+        std::size_t length = 0;
+        start = utf8::internal::count_blocks(utf8::internal::simd::active().utf8_length_from_utf32, start, end, length);
+        for (; start != end; ++start)
+            length += utf8::internal::utf8_length_of(static_cast<utfchar32_t>(*start));
+        return length;
+    }
+
+    inline std::size_t utf16_length_from_utf8(const std::string& s)
+    {
+        return utf8::utf16_length_from_utf8(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf32_length_from_utf8(const std::string& s)
+    {
+        return utf8::utf32_length_from_utf8(s.data(), s.data() + s.size());
+    }
+
+    // Bounded conversions between buffers, which neither throw nor allocate.
+    // They stop on a code point boundary, so a conversion that runs out of
+    // output or input can be resumed from where it stopped.
+    enum conversion_status {
+        conversion_ok,            // all of the input is converted
+        conversion_output_full,   // the next code point does not fit in the output
+        conversion_incomplete,    // the input ends within a sequence
+        conversion_invalid        // the input continues with an invalid sequence
+    };
+
+    struct conversion_result {
+        conversion_status status;
+        std::size_t read;         // code units of input converted
+        std::size_t written;      // code units of output written
+    };
+
+namespace internal
+{
+    inline conversion_result make_conversion_result(conversion_status status, std::size_t read, std::size_t written)
+    {
+        conversion_result result;
+        result.status = status;
+        result.read = read;
+        result.written = written;
+        return result;
+    }
+
+    // The status for a utf_error from decode_next or validate_next16
+    inline conversion_status conversion_status_of(utf_error err)
+    {
+        return (err == NOT_ENOUGH_ROOM) ? conversion_incomplete : conversion_invalid;
+    }
+} // namespace internal
+
+    inline conversion_result convert_utf8_to_utf16(const char* in, std::size_t in_length,
+                                                   utfchar16_t* out, std::size_t out_length)
+    {
+        const char* it = in;
+        const char* const end = in + in_length;
+        utfchar16_t* result = out;
+        utfchar16_t* const result_end = out + out_length;
+        conversion_status status = conversion_ok;
+        while (it != end) {
+            it = utf8::internal::transcode_blocks(utf8::internal::simd::active().utf8_to_utf16, it, end, result, result_end);
+            if (it == end)
+                break;
+            const char* const sequence_start = it;
+            utfchar32_t cp = 0;
+            const internal::utf_error err_code = utf8::internal::decode_next(it, end, cp);
+            if (err_code != internal::UTF8_OK) {
+                status = utf8::internal::conversion_status_of(err_code);
+                break;
+            }
+            if (result_end - result < (cp > 0xffff ? 2 : 1)) {
+                it = sequence_start;
+                status = conversion_output_full;
+                break;
+            }
+            result = utf8::internal::append16(cp, result);
+        }
+        return utf8::internal::make_conversion_result(status, static_cast<std::size_t>(it - in),
+                                                      static_cast<std::size_t>(result - out));
+    }
+
+    inline conversion_result convert_utf16_to_utf8(const utfchar16_t* in, std::size_t in_length,
+                                                   char* out, std::size_t out_length)
+    {
+        const utfchar16_t* it = in;
+        const utfchar16_t* const end = in + in_length;
+        char* result = out;
+        char* const result_end = out + out_length;
+        conversion_status status = conversion_ok;
+        const internal::simd::utf16_to_utf8_kernel kernel = utf8::internal::simd::active().utf16_to_utf8;
+        while (it != end) {
+            if (kernel) {
+                // The kernel writes octets, so it can write straight to the output
+                const uint16_t* first = reinterpret_cast<const uint16_t*>(it);
+                kernel(first, reinterpret_cast<const uint16_t*>(end), result, result_end);
+                it += first - reinterpret_cast<const uint16_t*>(it);
+                if (it == end)
+                    break;
+            }
+            const utfchar16_t* const sequence_start = it;
+            utfchar32_t cp = 0;
+            internal::utf_error err_code = utf8::internal::validate_next16(it, end, cp);
+            // A trail surrogate at the end of the input is invalid, not incomplete
+            if (err_code == internal::NOT_ENOUGH_ROOM && utf8::internal::is_trail_surrogate(*it))
+                err_code = internal::INVALID_LEAD;
+            if (err_code != internal::UTF8_OK) {
+                status = utf8::internal::conversion_status_of(err_code);
+                break;
+            }
+            if (static_cast<std::size_t>(result_end - result) < utf8::internal::utf8_length_of(cp)) {
+                it = sequence_start;
+                status = conversion_output_full;
+                break;
+            }
+            result = utf8::internal::append(cp, result);
+        }
+        return utf8::internal::make_conversion_result(status, static_cast<std::size_t>(it - in),
+                                                      static_cast<std::size_t>(result - out));
+    }
+
+    inline conversion_result convert_utf8_to_utf32(const char* in, std::size_t in_length,
+                                                   utfchar32_t* out, std::size_t out_length)
+    {
+        const char* it = in;
+        const char* const end = in + in_length;
+        utfchar32_t* result = out;
+        utfchar32_t* const result_end = out + out_length;
+        conversion_status status = conversion_ok;
+        while (it != end) {
+            it = utf8::internal::transcode_blocks(utf8::internal::simd::active().utf8_to_utf32, it, end, result, result_end);
+            if (it == end)
+                break;
+            if (result == result_end) {
+                status = conversion_output_full;
+                break;
+            }
+            utfchar32_t cp = 0;
+            const internal::utf_error err_code = utf8::internal::decode_next(it, end, cp);
+            if (err_code != internal::UTF8_OK) {
+                status = utf8::internal::conversion_status_of(err_code);
+                break;
+            }
+            *result++ = cp;
+        }
+        return utf8::internal::make_conversion_result(status, static_cast<std::size_t>(it - in),
+                                                      static_cast<std::size_t>(result - out));
+    }
+
+    inline conversion_result convert_utf32_to_utf8(const utfchar32_t* in, std::size_t in_length,
+                                                   char* out, std::size_t out_length)
+    {
+        const utfchar32_t* it = in;
+        const utfchar32_t* const end = in + in_length;
+        char* result = out;
+        char* const result_end = out + out_length;
+        conversion_status status = conversion_ok;
+        const internal::simd::utf32_to_utf8_kernel kernel = utf8::internal::simd::active().utf32_to_utf8;
+        while (it != end) {
+            if (kernel) {
+                const uint32_t* first = reinterpret_cast<const uint32_t*>(it);
+                kernel(first, reinterpret_cast<const uint32_t*>(end), result, result_end);
+                it += first - reinterpret_cast<const uint32_t*>(it);
+                if (it == end)
+                    break;
+            }
+            const utfchar32_t cp = *it;
+            if (!utf8::internal::is_code_point_valid(cp)) {
+                status = conversion_invalid;
+                break;
+            }
+            if (static_cast<std::size_t>(result_end - result) < utf8::internal::utf8_length_of(cp)) {
+                status = conversion_output_full;
+                break;
+            }
+            result = utf8::internal::append(cp, result);
+            ++it;
+        }
+        return utf8::internal::make_conversion_result(status, static_cast<std::size_t>(it - in),
+                                                      static_cast<std::size_t>(result - out));
+    }
+
+namespace internal
+{
+    // The conversions without exceptions: they stop on the first invalid
+    // sequence, leaving start there, and return its error
+    template <typename octet_iterator, typename u16bit_iterator>
+    utf_error utf8to16_until_invalid(octet_iterator& start, octet_iterator end, u16bit_iterator& result)
+    {
+        while (start != end) {
+            start = utf8::internal::utf8to16_blocks(start, end, result);
+            for (const octet_iterator ascii_end = utf8::internal::skip_ascii(start, end); start != ascii_end; ++start)
+                *result++ = static_cast<utfchar16_t>(utf8::internal::mask8(*start));
+            if (start == end)
+                break;
+            utfchar32_t cp = 0;
+            const utf_error err_code = utf8::internal::decode_next(start, end, cp);
+            if (err_code != UTF8_OK)
+                return err_code;
+            result = utf8::internal::append16(cp, result);
+        }
+        return UTF8_OK;
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator>
+    utf_error utf8to32_until_invalid(octet_iterator& start, octet_iterator end, u32bit_iterator& result)
+    {
+        while (start != end) {
+            start = utf8::internal::utf8to32_blocks(start, end, result);
+            for (const octet_iterator ascii_end = utf8::internal::skip_ascii(start, end); start != ascii_end; ++start)
+                *result++ = utf8::internal::mask8(*start);
+            if (start == end)
+                break;
+            utfchar32_t cp = 0;
+            const utf_error err_code = utf8::internal::decode_next(start, end, cp);
+            if (err_code != UTF8_OK)
+                return err_code;
+            *result++ = cp;
+        }
+        return UTF8_OK;
+    }
+
+    template <typename u16bit_iterator, typename octet_iterator>
+    utf_error utf16to8_until_invalid(u16bit_iterator& start, u16bit_iterator end, octet_iterator& result)
+    {
+        while (start != end) {
+            start = utf8::internal::utf16to8_blocks(start, end, result);
+            if (start == end)
+                break;
+            utfchar32_t cp = 0;
+            utf_error err_code = utf8::internal::validate_next16(start, end, cp);
+            // A trail surrogate at the end of the input is invalid, not incomplete
+            if (err_code == NOT_ENOUGH_ROOM && utf8::internal::is_trail_surrogate(utf8::internal::mask16(*start)))
+                err_code = INVALID_LEAD;
+            if (err_code != UTF8_OK)
+                return err_code;
+            result = utf8::internal::append(cp, result);
+        }
+        return UTF8_OK;
+    }
+
+    template <typename u32bit_iterator, typename octet_iterator>
+    utf_error utf32to8_until_invalid(u32bit_iterator& start, u32bit_iterator end, octet_iterator& result)
+    {
+        while (start != end) {
+            start = utf8::internal::utf32to8_blocks(start, end, result);
+            if (start == end)
+                break;
+            const utfchar32_t cp = static_cast<utfchar32_t>(*start);
+            if (!utf8::internal::is_code_point_valid(cp))
+                return INVALID_CODE_POINT;
+            result = utf8::internal::append(cp, result);
+            ++start;
+        }
+        return UTF8_OK;
+    }
+} // namespace internal
+
+    // Conversions that validate as they go and report the first invalid
+    // sequence instead of throwing, so a prior find_invalid scan is not
+    // needed; everything before it is converted.
+    template <typename output_iterator>
+    struct transcoding_result {
+        output_iterator out;              // past the last code unit written
+        std::size_t offset;               // code units of input converted; the invalid sequence starts there
+        utf8::internal::utf_error error;  // UTF8_OK if all of the input is converted
+    };
+
+namespace internal
+{
+    template <typename output_iterator>
+    transcoding_result<output_iterator> make_transcoding_result(output_iterator out, std::size_t offset, utf_error error)
+    {
+        // Aggregate initialization: output iterators need not be default constructible
+        const transcoding_result<output_iterator> result = {out, offset, error};
+        return result;
+    }
+} // namespace internal
+
+    template <typename octet_iterator, typename u16bit_iterator>
+    transcoding_result<u16bit_iterator> try_utf8to16(octet_iterator start, octet_iterator end, u16bit_iterator result)
+    {
+        octet_iterator it = start;
+        const internal::utf_error err_code = utf8::internal::utf8to16_until_invalid(it, end, result);
+        return utf8::internal::make_transcoding_result(result, static_cast<std::size_t>(std::distance(start, it)), err_code);
+    }
+
+    template <typename octet_iterator, typename u32bit_iterator>
+    transcoding_result<u32bit_iterator> try_utf8to32(octet_iterator start, octet_iterator end, u32bit_iterator result)
+    {
+        octet_iterator it = start;
+        const internal::utf_error err_code = utf8::internal::utf8to32_until_invalid(it, end, result);
+        return utf8::internal::make_transcoding_result(result, static_cast<std::size_t>(std::distance(start, it)), err_code);
+    }
+
     template <typename octet_iterator>
     inline bool starts_with_bom (octet_iterator it, octet_iterator end)
     {
@@ -39,30 +39,42 @@ namespace utf8
 
     inline std::string utf16to8(const std::u16string& s)
     {
-        std::string result;
-        utf16to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf16to8_string<std::string>(s.data(), s.data() + s.size());
     }
 
     inline std::u16string utf8to16(const std::string& s)
     {
-        std::u16string result;
-        utf8to16(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to16_string<std::u16string>(s.data(), s.data() + s.size());
     }
 
     inline std::string utf32to8(const std::u32string& s)
     {
-        std::string result;
-        utf32to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf32to8_string<std::string>(s.data(), s.data() + s.size());
     }
 
     inline std::u32string utf8to32(const std::string& s)
     {
-        std::u32string result;
-        utf8to32(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to32_string<std::u32string>(s.data(), s.data() + s.size());
+    }
+
+    inline std::string latin1to8(const std::string& s)
+    {
+        return utf8::internal::latin1to8_string<std::string>(s.data(), s.data() + s.size());
+    }
+
+    inline std::string utf8tolatin1(const std::string& s)
+    {
+        return utf8::internal::utf8tolatin1_string<std::string>(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf8_length_from_utf16(const std::u16string& s)
+    {
+        return utf8_length_from_utf16(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf8_length_from_utf32(const std::u32string& s)
+    {
+        return utf8_length_from_utf32(s.data(), s.data() + s.size());
     }
 } // namespace utf8
 
@@ -34,55 +34,74 @@ namespace utf8
 {
     inline std::string utf16to8(std::u16string_view s)
     {
-        std::string result;
-        utf16to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf16to8_string<std::string>(s.data(), s.data() + s.size());
     }
 
     inline std::u16string utf8to16(std::string_view s)
     {
-        std::u16string result;
-        utf8to16(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to16_string<std::u16string>(s.data(), s.data() + s.size());
     }
 
     inline std::string utf32to8(std::u32string_view s)
     {
-        std::string result;
-        utf32to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf32to8_string<std::string>(s.data(), s.data() + s.size());
     }
 
     inline std::u32string utf8to32(std::string_view s)
     {
-        std::u32string result;
-        utf8to32(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to32_string<std::u32string>(s.data(), s.data() + s.size());
+    }
+
+    inline std::string latin1to8(std::string_view s)
+    {
+        return utf8::internal::latin1to8_string<std::string>(s.data(), s.data() + s.size());
+    }
+
+    inline std::string utf8tolatin1(std::string_view s)
+    {
+        return utf8::internal::utf8tolatin1_string<std::string>(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf16_length_from_utf8(std::string_view s)
+    {
+        return utf16_length_from_utf8(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf32_length_from_utf8(std::string_view s)
+    {
+        return utf32_length_from_utf8(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf8_length_from_utf16(std::u16string_view s)
+    {
+        return utf8_length_from_utf16(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf8_length_from_utf32(std::u32string_view s)
+    {
+        return utf8_length_from_utf32(s.data(), s.data() + s.size());
     }
 
     inline std::size_t find_invalid(std::string_view s)
     {
-        std::string_view::const_iterator invalid = find_invalid(s.begin(), s.end());
-        return (invalid == s.end()) ? std::string_view::npos : static_cast<std::size_t>(invalid - s.begin());
+        const char* invalid = utf8::internal::find_invalid(s.data(), s.data() + s.size());
+        return (invalid == s.data() + s.size()) ? std::string_view::npos : static_cast<std::size_t>(invalid - s.data());
     }
 
     inline bool is_valid(std::string_view s)
     {
-        return is_valid(s.begin(), s.end());
+        return (find_invalid(s) == std::string_view::npos);
     }
 
     inline std::string replace_invalid(std::string_view s, char32_t replacement)
     {
-        std::string result;
-        replace_invalid(s.begin(), s.end(), std::back_inserter(result), replacement);
-        return result;
+        return utf8::internal::replace_invalid_string<std::string>(s.data(), s.data() + s.size(), replacement);
     }
 
     inline std::string replace_invalid(std::string_view s)
     {
-        std::string result;
-        replace_invalid(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::replace_invalid_string<std::string>(s.data(), s.data() + s.size(),
+                                                                    static_cast<char32_t>(0xfffd));
     }
 
     inline bool starts_with_bom(std::string_view s)
@@ -34,83 +34,84 @@ namespace utf8
 {
     inline std::u8string utf16tou8(const std::u16string& s)
     {
-        std::u8string result;
-        utf16to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf16to8_string<std::u8string>(s.data(), s.data() + s.size());
     }
 
     inline std::u8string utf16tou8(std::u16string_view s)
     {
-        std::u8string result;
-        utf16to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf16to8_string<std::u8string>(s.data(), s.data() + s.size());
     }
 
     inline std::u16string utf8to16(const std::u8string& s)
     {
-        std::u16string result;
-        utf8to16(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to16_string<std::u16string>(s.data(), s.data() + s.size());
     }
 
     inline std::u16string utf8to16(const std::u8string_view& s)
     {
-        std::u16string result;
-        utf8to16(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to16_string<std::u16string>(s.data(), s.data() + s.size());
     }
 
     inline std::u8string utf32tou8(const std::u32string& s)
     {
-        std::u8string result;
-        utf32to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf32to8_string<std::u8string>(s.data(), s.data() + s.size());
     }
 
     inline std::u8string utf32tou8(const std::u32string_view& s)
     {
-        std::u8string result;
-        utf32to8(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf32to8_string<std::u8string>(s.data(), s.data() + s.size());
     }
 
     inline std::u32string utf8to32(const std::u8string& s)
     {
-        std::u32string result;
-        utf8to32(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to32_string<std::u32string>(s.data(), s.data() + s.size());
     }
 
     inline std::u32string utf8to32(const std::u8string_view& s)
     {
-        std::u32string result;
-        utf8to32(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::utf8to32_string<std::u32string>(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf16_length_from_utf8(const std::u8string& s)
+    {
+        return utf16_length_from_utf8(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf16_length_from_utf8(const std::u8string_view& s)
+    {
+        return utf16_length_from_utf8(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf32_length_from_utf8(const std::u8string& s)
+    {
+        return utf32_length_from_utf8(s.data(), s.data() + s.size());
+    }
+
+    inline std::size_t utf32_length_from_utf8(const std::u8string_view& s)
+    {
+        return utf32_length_from_utf8(s.data(), s.data() + s.size());
     }
 
     inline std::size_t find_invalid(const std::u8string& s)
     {
-        std::u8string::const_iterator invalid = find_invalid(s.begin(), s.end());
-        return (invalid == s.end()) ? std::string_view::npos : static_cast<std::size_t>(invalid - s.begin());
+        const char8_t* invalid = utf8::internal::find_invalid(s.data(), s.data() + s.size());
+        return (invalid == s.data() + s.size()) ? std::string_view::npos : static_cast<std::size_t>(invalid - s.data());
     }
 
     inline bool is_valid(const std::u8string& s)
     {
-        return is_valid(s.begin(), s.end());
+        return (find_invalid(s) == std::string_view::npos);
     }
 
     inline std::u8string replace_invalid(const std::u8string& s, char32_t replacement)
     {
-        std::u8string result;
-        replace_invalid(s.begin(), s.end(), std::back_inserter(result), replacement);
-        return result;
+        return utf8::internal::replace_invalid_string<std::u8string>(s.data(), s.data() + s.size(), replacement);
     }
 
     inline std::u8string replace_invalid(const std::u8string& s)
     {
-        std::u8string result;
-        replace_invalid(s.begin(), s.end(), std::back_inserter(result));
-        return result;
+        return utf8::internal::replace_invalid_string<std::u8string>(s.data(), s.data() + s.size(),
+                                                                      static_cast<char32_t>(0xfffd));
     }
 
     inline bool starts_with_bom(const std::u8string& s)
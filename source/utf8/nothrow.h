@@ -0,0 +1,164 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#ifndef UTF8_FOR_CPP_NOTHROW_H_9d2e6f3a_41b7_4c85_a0e3_7b5c1d8f2e64
+#define UTF8_FOR_CPP_NOTHROW_H_9d2e6f3a_41b7_4c85_a0e3_7b5c1d8f2e64
+
+#include "core.h"
+
+namespace utf8
+{
+    // The checked functions that report errors instead of throwing them:
+    // they validate the input just the same, but they never unwind, and
+    // they can be used with exceptions disabled
+    namespace nothrow
+    {
+        // The outcome of a function: its value, the error, if any, and an
+        // iterator position, all as described with each function
+        template <typename value_type, typename iterator>
+        struct outcome {
+            value_type value;
+            utf8::internal::utf_error error;  // UTF8_OK on success
+            iterator position;
+        };
+    } // namespace utf8::nothrow
+
+namespace internal
+{
+    template <typename value_type, typename iterator>
+    nothrow::outcome<value_type, iterator> make_outcome(value_type value, utf_error error, iterator position)
+    {
+        const nothrow::outcome<value_type, iterator> result = {value, error, position};
+        return result;
+    }
+} // namespace internal
+
+    namespace nothrow
+    {
+        // The code point appended and the output past it; nothing is
+        // appended for an invalid code point
+        template <typename octet_iterator>
+        outcome<utfchar32_t, octet_iterator> append(utfchar32_t cp, octet_iterator result)
+        {
+            if (!utf8::internal::is_code_point_valid(cp))
+                return utf8::internal::make_outcome(cp, internal::INVALID_CODE_POINT, result);
+            return utf8::internal::make_outcome(cp, internal::UTF8_OK, utf8::internal::append(cp, result));
+        }
+
+        // The code point and the position past it; for invalid input, the
+        // position of the invalid sequence
+        template <typename octet_iterator>
+        outcome<utfchar32_t, octet_iterator> next(octet_iterator it, octet_iterator end)
+        {
+            utfchar32_t cp = 0;
+            const internal::utf_error err_code = utf8::internal::decode_next(it, end, cp);
+            return utf8::internal::make_outcome(cp, err_code, it);
+        }
+
+        // The code point before it and its position
+        template <typename octet_iterator>
+        outcome<utfchar32_t, octet_iterator> prior(octet_iterator it, octet_iterator start)
+        {
+            if (it == start)
+                return utf8::internal::make_outcome(utfchar32_t(0), internal::NOT_ENOUGH_ROOM, it);
+            const octet_iterator end = it;
+            // Go back until we hit either a lead octet or start
+            while (utf8::internal::is_trail(*(--it)))
+                if (it == start)
+                    return utf8::internal::make_outcome(utfchar32_t(0), internal::INVALID_LEAD, it);
+            octet_iterator sequence_end = it;
+            utfchar32_t cp = 0;
+            const internal::utf_error err_code = utf8::internal::decode_next(sequence_end, end, cp);
+            return utf8::internal::make_outcome(cp, err_code, it);
+        }
+
+        // The number of code points moved by, backward if n is negative,
+        // and the position reached; on an error, the position of the
+        // invalid sequence
+        template <typename octet_iterator, typename distance_type>
+        outcome<distance_type, octet_iterator> advance(octet_iterator it, distance_type n, octet_iterator end)
+        {
+            const distance_type zero(0);
+            distance_type moved = zero;
+            // Contiguous input: valid code points are passed in bulk first
+            if (n < zero) {
+                // backward
+                moved = zero - static_cast<distance_type>(utf8::internal::skip_valid_code_points_back(end, it, -static_cast<std::ptrdiff_t>(n)));
+                for (; moved > n; --moved) {
+                    const outcome<utfchar32_t, octet_iterator> previous = utf8::nothrow::prior(it, end);
+                    if (previous.error != internal::UTF8_OK)
+                        return utf8::internal::make_outcome(moved, previous.error, previous.position);
+                    it = previous.position;
+                }
+            } else {
+                // forward
+                moved = static_cast<distance_type>(utf8::internal::skip_valid_code_points(it, end, static_cast<std::ptrdiff_t>(n)));
+                for (; moved < n; ++moved) {
+                    utfchar32_t cp = 0;
+                    const internal::utf_error err_code = utf8::internal::decode_next(it, end, cp);
+                    if (err_code != internal::UTF8_OK)
+                        return utf8::internal::make_outcome(moved, err_code, it);
+                }
+            }
+            return utf8::internal::make_outcome(moved, internal::UTF8_OK, it);
+        }
+
+        // The conversions: the output past what is converted and the
+        // position in the input where the conversion stopped, which is
+        // the end of the input unless it is invalid
+        template <typename u16bit_iterator, typename octet_iterator>
+        outcome<octet_iterator, u16bit_iterator> utf16to8(u16bit_iterator start, u16bit_iterator end, octet_iterator result)
+        {
+            const internal::utf_error err_code = utf8::internal::utf16to8_until_invalid(start, end, result);
+            return utf8::internal::make_outcome(result, err_code, start);
+        }
+
+        template <typename octet_iterator, typename u16bit_iterator>
+        outcome<u16bit_iterator, octet_iterator> utf8to16(octet_iterator start, octet_iterator end, u16bit_iterator result)
+        {
+            const internal::utf_error err_code = utf8::internal::utf8to16_until_invalid(start, end, result);
+            return utf8::internal::make_outcome(result, err_code, start);
+        }
+
+        template <typename u32bit_iterator, typename octet_iterator>
+        outcome<octet_iterator, u32bit_iterator> utf32to8(u32bit_iterator start, u32bit_iterator end, octet_iterator result)
+        {
+            const internal::utf_error err_code = utf8::internal::utf32to8_until_invalid(start, end, result);
+            return utf8::internal::make_outcome(result, err_code, start);
+        }
+
+        template <typename octet_iterator, typename u32bit_iterator>
+        outcome<u32bit_iterator, octet_iterator> utf8to32(octet_iterator start, octet_iterator end, u32bit_iterator result)
+        {
+            const internal::utf_error err_code = utf8::internal::utf8to32_until_invalid(start, end, result);
+            return utf8::internal::make_outcome(result, err_code, start);
+        }
+    } // namespace utf8::nothrow
+} // namespace utf8
+
+#endif // header guard
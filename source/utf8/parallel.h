@@ -0,0 +1,209 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_PARALLEL_H_4c3f5b8c_6a9d_46f5_b94a_34608495c3ab
+#define UTF8_FOR_CPP_PARALLEL_H_4c3f5b8c_6a9d_46f5_b94a_34608495c3ab
+
+// Multi-threaded validation of large buffers. Not included by utf8.h:
+// it needs C++ 11 and the standard thread support library.
+
+#include "core.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace utf8
+{
+namespace internal
+{
+    // Chunks smaller than this are not worth a task of their own
+    const std::size_t PARALLEL_MIN_CHUNK = 1 << 16;
+    // The workers check whether an earlier chunk has failed after each block
+    const std::size_t PARALLEL_BLOCK = 1 << 20;
+
+    // Moves a split point past trail octets. A valid sequence never spans an
+    // ASCII or a lead octet, so if the text before the split point is valid,
+    // validation from there goes in step with the validation from the start.
+    inline const char* align_to_sequence(const char* it, const char* end)
+    {
+        while (it != end && utf8::internal::is_trail(*it))
+            ++it;
+        return it;
+    }
+
+    class parallel_validation {
+        std::vector<const char*> bounds;
+        std::vector<const char*> invalid;
+        std::atomic<std::size_t> first_failed;
+      public:
+        parallel_validation(const char* start, const char* end, std::size_t task_count)
+            : bounds(task_count + 1), invalid(task_count), first_failed(task_count)
+        {
+            const std::size_t length = static_cast<std::size_t>(end - start);
+            bounds[0] = start;
+            for (std::size_t i = 1; i < task_count; ++i) {
+                const char* split = start + length / task_count * i;
+                bounds[i] = align_to_sequence((std::max)(split, bounds[i - 1]), end);
+            }
+            bounds[task_count] = end;
+        }
+
+        std::size_t task_count() const { return invalid.size(); }
+
+        void validate(std::size_t task)
+        {
+            const char* it = bounds[task];
+            const char* chunk_end = bounds[task + 1];
+            while (it != chunk_end) {
+                // Errors past the first failed chunk do not matter
+                if (first_failed.load(std::memory_order_relaxed) < task)
+                    return;
+                const char* block_end = chunk_end;
+                if (static_cast<std::size_t>(chunk_end - it) > PARALLEL_BLOCK)
+                    block_end = align_to_sequence(it + PARALLEL_BLOCK, chunk_end);
+                const char* found = utf8::internal::find_invalid(it, block_end);
+                if (found != block_end) {
+                    invalid[task] = found;
+                    std::size_t failed = first_failed.load();
+                    while (task < failed && !first_failed.compare_exchange_weak(failed, task))
+                        ;
+                    return;
+                }
+                it = block_end;
+            }
+        }
+
+        // Valid once all the tasks are done
+        const char* result() const
+        {
+            const std::size_t failed = first_failed.load();
+            return (failed < task_count()) ? invalid[failed] : bounds[task_count()];
+        }
+    };
+
+    inline std::size_t parallel_task_count(const char* start, const char* end, std::size_t requested)
+    {
+        const std::size_t most = static_cast<std::size_t>(end - start) / PARALLEL_MIN_CHUNK;
+        return (std::max)(std::size_t(1), (std::min)(requested, most));
+    }
+} // namespace internal
+
+    // Validates the text on thread_count threads, the calling one included;
+    // 0 stands for std::thread::hardware_concurrency(). Returns the same
+    // position as the single-threaded version.
+    inline const char* find_invalid(const char* start, const char* end, std::size_t thread_count)
+    {
+        if (thread_count == 0)
+            thread_count = std::thread::hardware_concurrency();
+        const std::size_t task_count = utf8::internal::parallel_task_count(start, end, thread_count);
+        if (task_count == 1)
+            return utf8::internal::find_invalid(start, end);
+
+        utf8::internal::parallel_validation validation(start, end, task_count);
+        std::vector<std::thread> threads;
+        threads.reserve(task_count - 1);
+        std::size_t task = 1;
+        try {
+            for (; task < task_count; ++task)
+                threads.push_back(std::thread(&utf8::internal::parallel_validation::validate, &validation, task));
+        } catch (const std::system_error&) {
+            // Out of threads: the calling thread takes over the rest
+        }
+        validation.validate(0);
+        for (; task < task_count; ++task)
+            validation.validate(task);
+        for (std::size_t i = 0; i < threads.size(); ++i)
+            threads[i].join();
+        return validation.result();
+    }
+
+    // Splits the text into up to task_count tasks and hands them to the
+    // executor, a callable that takes a std::function<void()> and runs it,
+    // usually on a thread pool. Returns when all the tasks are done, so the
+    // executor must run every task it is given. An executor may throw to
+    // refuse a task: the tasks it took before are waited for, and the
+    // exception is passed on.
+    template <typename executor>
+    const char* find_invalid(const char* start, const char* end, std::size_t task_count, executor&& exec)
+    {
+        task_count = utf8::internal::parallel_task_count(start, end, task_count);
+        if (task_count == 1)
+            return utf8::internal::find_invalid(start, end);
+
+        utf8::internal::parallel_validation validation(start, end, task_count);
+        std::mutex mutex;
+        std::condition_variable all_done;
+        std::size_t pending = task_count;
+        std::size_t task = 0;
+        try {
+            for (; task < task_count; ++task) {
+                exec(std::function<void()>([&validation, &mutex, &all_done, &pending, task]() {
+                    validation.validate(task);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (--pending == 0)
+                        all_done.notify_one();
+                }));
+            }
+        } catch (...) {
+            // The tasks handed over refer to the locals, so they must be done
+            // before the stack unwinds
+            std::unique_lock<std::mutex> lock(mutex);
+            pending -= task_count - task;
+            while (pending != 0)
+                all_done.wait(lock);
+            throw;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        while (pending != 0)
+            all_done.wait(lock);
+        return validation.result();
+    }
+
+    inline std::size_t find_invalid(const std::string& s, std::size_t thread_count)
+    {
+        const char* invalid = utf8::find_invalid(s.data(), s.data() + s.size(), thread_count);
+        return (invalid == s.data() + s.size()) ? std::string::npos : static_cast<std::size_t>(invalid - s.data());
+    }
+
+    inline bool is_valid(const char* start, const char* end, std::size_t thread_count)
+    {
+        return (utf8::find_invalid(start, end, thread_count) == end);
+    }
+
+    inline bool is_valid(const std::string& s, std::size_t thread_count)
+    {
+        return (utf8::find_invalid(s, thread_count) == std::string::npos);
+    }
+
+} // namespace utf8
+
+#endif // header guard
@@ -0,0 +1,564 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_SIMD_AVX2_H_e6417e34_75dc_47e5_be0b_530f269c72cf
+#define UTF8_FOR_CPP_SIMD_AVX2_H_e6417e34_75dc_47e5_be0b_530f269c72cf
+
+#include "x86.h"
+
+#ifdef UTF_CPP_SIMD_X86
+
+namespace utf8
+{
+namespace internal
+{
+namespace simd
+{
+// 32 bytes per step, same algorithm as the SSE kernels
+namespace avx2
+{
+    inline UTF_CPP_TARGET_AVX2 __m256i load_table(const unsigned char* table)
+    {
+        return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+    }
+
+    inline UTF_CPP_TARGET_AVX2 __m256i high_nibbles(__m256i v)
+    {
+        return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0f));
+    }
+
+    // The bytes preceding each byte of input by 1, 2 or 3 positions
+    inline UTF_CPP_TARGET_AVX2 __m256i prev1(__m256i input, __m256i prev_input)
+    {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 15);
+    }
+
+    inline UTF_CPP_TARGET_AVX2 __m256i prev2(__m256i input, __m256i prev_input)
+    {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 14);
+    }
+
+    inline UTF_CPP_TARGET_AVX2 __m256i prev3(__m256i input, __m256i prev_input)
+    {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 13);
+    }
+
+    inline UTF_CPP_TARGET_AVX2 __m256i check_special_cases(__m256i input, __m256i prev1)
+    {
+        const __m256i byte_1_high = _mm256_shuffle_epi8(load_table(byte_1_high_table), high_nibbles(prev1));
+        const __m256i byte_1_low  = _mm256_shuffle_epi8(load_table(byte_1_low_table),
+                                                        _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)));
+        const __m256i byte_2_high = _mm256_shuffle_epi8(load_table(byte_2_high_table), high_nibbles(input));
+        return _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+    }
+
+    inline UTF_CPP_TARGET_AVX2 __m256i check_multibyte_lengths(__m256i input, __m256i prev_input, __m256i special_cases)
+    {
+        const __m256i is_third_byte  = _mm256_subs_epu8(prev2(input, prev_input),
+                                                        _mm256_set1_epi8(static_cast<char>(0xe0u - 0x80u)));
+        const __m256i is_fourth_byte = _mm256_subs_epu8(prev3(input, prev_input),
+                                                        _mm256_set1_epi8(static_cast<char>(0xf0u - 0x80u)));
+        const __m256i must_be_trail = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte),
+                                                       _mm256_set1_epi8(static_cast<char>(0x80)));
+        return _mm256_xor_si256(must_be_trail, special_cases);
+    }
+
+    inline UTF_CPP_TARGET_AVX2 __m256i incomplete_limits_256()
+    {
+        // Only the last three bytes of the 32 byte block matter
+        return _mm256_inserti128_si256(_mm256_set1_epi8(static_cast<char>(0xff)),
+                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(incomplete_limits)), 1);
+    }
+
+    // Returns how far from start the input is known to be valid UTF-8; see resync()
+    inline UTF_CPP_TARGET_AVX2 const char* validate(const char* start, const char* end)
+    {
+        const __m256i limits = incomplete_limits_256();
+        __m256i prev_input = _mm256_setzero_si256();
+        __m256i prev_incomplete = _mm256_setzero_si256();
+        const char* it = start;
+        while (end - it >= 32) {
+            const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            __m256i error;
+            if (_mm256_movemask_epi8(input) == 0) {
+                error = prev_incomplete;
+                prev_incomplete = _mm256_setzero_si256();
+            } else {
+                error = check_multibyte_lengths(input, prev_input,
+                                                check_special_cases(input, prev1(input, prev_input)));
+                prev_incomplete = _mm256_subs_epu8(input, limits);
+            }
+            if (!_mm256_testz_si256(error, error))
+                break;
+            prev_input = input;
+            it += 32;
+        }
+        return resync(start, it);
+    }
+
+    // The pshufb control that packs the eight 16 bit lanes selected by keep.
+    // It is built with BMI2: each kept lane index is extracted from
+    // 0x0706050403020100 and doubled into a pair of byte indices.
+    inline UTF_CPP_TARGET_AVX2 __m128i pack_utf16_shuffle(unsigned int keep)
+    {
+        // The 64 bit constants are assembled from 32 bit halves for C++98
+        const uint64_t ones = (static_cast<uint64_t>(0x01010101u) << 32) | 0x01010101u;
+        const uint64_t indices = (static_cast<uint64_t>(0x07060504u) << 32) | 0x03020100u;
+        const uint64_t lanes = _pdep_u64(keep, ones) * 0xff;
+        const __m128i index = _mm_cvtsi64_si128(static_cast<int64_t>(_pext_u64(indices, lanes)));
+        const __m128i pairs = _mm_unpacklo_epi8(index, index);
+        return _mm_add_epi8(_mm_add_epi8(pairs, pairs), _mm_set1_epi16(0x0100));
+    }
+
+    // Stores the eight 16 bit lanes of units selected by keep
+    inline UTF_CPP_TARGET_AVX2 void store_packed_utf16(__m128i units, unsigned int keep, uint16_t*& out)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(units, pack_utf16_shuffle(keep)));
+        out += _mm_popcnt_u32(keep);
+    }
+
+    // As above, widened to 32 bits
+    inline UTF_CPP_TARGET_AVX2 void store_packed_utf16(__m128i units, unsigned int keep, uint32_t*& out)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                            _mm256_cvtepu16_epi32(_mm_shuffle_epi8(units, pack_utf16_shuffle(keep))));
+        out += _mm_popcnt_u32(keep);
+    }
+
+    // As above, narrowed to Latin-1
+    inline UTF_CPP_TARGET_AVX2 void store_packed_utf16(__m128i units, unsigned int keep, char*& out)
+    {
+        const __m128i packed = _mm_shuffle_epi8(units, pack_utf16_shuffle(keep));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(packed, _mm_setzero_si128()));
+        out += _mm_popcnt_u32(keep);
+    }
+
+    // See sse::utf16_units
+    inline UTF_CPP_TARGET_AVX2 __m256i utf16_units(__m256i w0, __m256i w1, __m256i w2, __m256i two_end, __m256i three_end)
+    {
+        const __m256i low6 = _mm256_set1_epi16(0x3f);
+        const __m256i t2 = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(w1, low6), 6), _mm256_and_si256(w0, low6));
+        const __m256i t3 = _mm256_or_si256(_mm256_slli_epi16(w2, 12), t2);
+        return _mm256_blendv_epi8(_mm256_blendv_epi8(w0, t2, two_end), t3, three_end);
+    }
+
+    // Stores 32 ASCII octets as code units
+    inline UTF_CPP_TARGET_AVX2 void store_ascii(__m128i low, __m128i high, uint16_t* out)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi16(low));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi16(high));
+    }
+
+    inline UTF_CPP_TARGET_AVX2 void store_ascii(__m128i low, __m128i high, uint32_t* out)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu8_epi32(low));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(low, 8)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16), _mm256_cvtepu8_epi32(high));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(high, 8)));
+    }
+
+    inline UTF_CPP_TARGET_AVX2 void store_ascii(__m128i low, __m128i high, char* out)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_setr_m128i(low, high));
+    }
+
+    // See sse::wide_leads
+    inline UTF_CPP_TARGET_AVX2 unsigned int wide_leads(__m256i, const uint16_t*)
+    {
+        return 0;
+    }
+
+    inline UTF_CPP_TARGET_AVX2 unsigned int wide_leads(__m256i, const uint32_t*)
+    {
+        return 0;
+    }
+
+    inline UTF_CPP_TARGET_AVX2 unsigned int wide_leads(__m256i input, const char*)
+    {
+        const __m256i wide = _mm256_cmpeq_epi8(_mm256_max_epu8(input, _mm256_set1_epi8(static_cast<char>(0xc4))), input);
+        return static_cast<unsigned int>(_mm256_movemask_epi8(wide));
+    }
+
+    // UTF-8 -> UTF-16, UTF-32 or Latin-1, as sse::utf8_to_units with 32 byte blocks
+    template <typename unit_type>
+    inline UTF_CPP_TARGET_AVX2 void utf8_to_units(const char*& in, const char* end,
+                                                 unit_type*& out, unit_type* out_end)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i limits = incomplete_limits_256();
+        const char* it = in;
+        unit_type* result = out;
+        while (end - it >= 32 && out_end - result >= 32) {
+            const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const __m128i input_low = _mm256_castsi256_si128(input);
+            const __m128i input_high = _mm256_extracti128_si256(input, 1);
+            if (_mm256_movemask_epi8(input) == 0) {
+                store_ascii(input_low, input_high, result);
+                it += 32;
+                result += 32;
+                continue;
+            }
+            // it is on a sequence boundary, so the block is validated on its own
+            const __m256i input_1 = prev1(input, zero);
+            const __m256i input_2 = prev2(input, zero);
+            const __m256i error = check_multibyte_lengths(input, zero, check_special_cases(input, input_1));
+            if (!_mm256_testz_si256(error, error))
+                break;
+            // Stop before a four octet sequence, or one running past the block
+            const __m256i lead4 = _mm256_cmpeq_epi8(_mm256_max_epu8(input, _mm256_set1_epi8(static_cast<char>(0xf0))), input);
+            const __m256i complete = _mm256_cmpeq_epi8(_mm256_subs_epu8(input, limits), zero);
+            const unsigned int stop = ~static_cast<unsigned int>(_mm256_movemask_epi8(complete))
+                                      | static_cast<unsigned int>(_mm256_movemask_epi8(lead4)) | wide_leads(input, result);
+            const unsigned int length = stop ? static_cast<unsigned int>(_tzcnt_u32(stop)) : 32u;
+            if (length == 0)
+                break;
+
+            const __m256i trail = _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0xc0)), input);
+            const __m256i after_trail = prev1(trail, zero);
+            const __m256i two_end = _mm256_andnot_si256(after_trail, trail);
+            const __m256i three_end = _mm256_and_si256(after_trail, trail);
+            const unsigned int in_block = (length == 32) ? ~0u : ((1u << length) - 1);
+            const unsigned int emit = ~(static_cast<unsigned int>(_mm256_movemask_epi8(trail)) >> 1) & in_block;
+
+            for (int half = 0; half < 2; ++half) {
+                const __m256i units = utf16_units(
+                    _mm256_cvtepu8_epi16(half ? input_high : input_low),
+                    _mm256_cvtepu8_epi16(half ? _mm256_extracti128_si256(input_1, 1) : _mm256_castsi256_si128(input_1)),
+                    _mm256_cvtepu8_epi16(half ? _mm256_extracti128_si256(input_2, 1) : _mm256_castsi256_si128(input_2)),
+                    _mm256_cvtepi8_epi16(half ? _mm256_extracti128_si256(two_end, 1) : _mm256_castsi256_si128(two_end)),
+                    _mm256_cvtepi8_epi16(half ? _mm256_extracti128_si256(three_end, 1) : _mm256_castsi256_si128(three_end)));
+                const unsigned int keep = emit >> (half * 16);
+                store_packed_utf16(_mm256_castsi256_si128(units), keep & 0xff, result);
+                store_packed_utf16(_mm256_extracti128_si256(units, 1), (keep >> 8) & 0xff, result);
+            }
+            it += length;
+        }
+        in = it;
+        out = result;
+    }
+
+    inline UTF_CPP_TARGET_AVX2 void utf8_to_utf16(const char*& in, const char* end,
+                                                 uint16_t*& out, uint16_t* out_end)
+    {
+        utf8_to_units(in, end, out, out_end);
+    }
+
+    inline UTF_CPP_TARGET_AVX2 void utf8_to_utf32(const char*& in, const char* end,
+                                                 uint32_t*& out, uint32_t* out_end)
+    {
+        utf8_to_units(in, end, out, out_end);
+    }
+
+    inline UTF_CPP_TARGET_AVX2 void utf8_to_latin1(const char*& in, const char* end,
+                                                  char*& out, char* out_end)
+    {
+        utf8_to_units(in, end, out, out_end);
+    }
+
+    // Latin-1 -> UTF-8, as sse::latin1_to_utf8 with 32 byte blocks
+    inline UTF_CPP_TARGET_AVX2 void latin1_to_utf8(const char*& in, const char* end,
+                                                  char*& out, char* out_end)
+    {
+        const char* it = in;
+        char* result = out;
+        while (end - it >= 32 && out_end - result >= 64) {
+            const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            if (_mm256_movemask_epi8(input) == 0) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(result), input);
+                result += 32;
+            } else {
+                const __m256i low = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(input));
+                const __m256i high = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(input, 1));
+                store_utf8_below_800(_mm256_castsi256_si128(low), result);
+                store_utf8_below_800(_mm256_extracti128_si256(low, 1), result);
+                store_utf8_below_800(_mm256_castsi256_si128(high), result);
+                store_utf8_below_800(_mm256_extracti128_si256(high, 1), result);
+            }
+            it += 32;
+        }
+        in = it;
+        out = result;
+    }
+
+    // Byte order, as sse::swap_bytes with 32 byte blocks
+    template <typename unit_type>
+    inline UTF_CPP_TARGET_AVX2 void swap_bytes(unit_type*& units, const unit_type* end, __m256i shuffle)
+    {
+        const std::ptrdiff_t block = 32 / sizeof(unit_type);
+        unit_type* it = units;
+        for (; end - it >= block; it += block) {
+            __m256i* const p = reinterpret_cast<__m256i*>(it);
+            _mm256_storeu_si256(p, _mm256_shuffle_epi8(_mm256_loadu_si256(p), shuffle));
+        }
+        units = it;
+    }
+
+    inline UTF_CPP_TARGET_AVX2 void swap_bytes16(uint16_t*& units, const uint16_t* end)
+    {
+        swap_bytes(units, end, _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                                1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+    }
+
+    inline UTF_CPP_TARGET_AVX2 void swap_bytes32(uint32_t*& units, const uint32_t* end)
+    {
+        swap_bytes(units, end, _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    }
+
+    // See sse::utf8_octets
+    inline UTF_CPP_TARGET_AVX2 __m256i utf8_octets(__m256i cp, __m256i two_or_more, __m256i three_or_more, __m256i four)
+    {
+        const __m256i low6 = _mm256_set1_epi32(0x3f);
+        const __m256i cont = _mm256_set1_epi32(0x80);
+        const __m256i c0 = _mm256_or_si256(cont, _mm256_and_si256(cp, low6));
+        const __m256i c1 = _mm256_or_si256(cont, _mm256_and_si256(_mm256_srli_epi32(cp, 6), low6));
+        const __m256i c2 = _mm256_or_si256(cont, _mm256_and_si256(_mm256_srli_epi32(cp, 12), low6));
+        const __m256i enc2 = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(0xc0), _mm256_srli_epi32(cp, 6)),
+                                             _mm256_slli_epi32(c0, 8));
+        const __m256i enc3 = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(0xe0), _mm256_srli_epi32(cp, 12)),
+                                             _mm256_or_si256(_mm256_slli_epi32(c1, 8), _mm256_slli_epi32(c0, 16)));
+        const __m256i enc4 = _mm256_or_si256(_mm256_or_si256(_mm256_set1_epi32(0xf0), _mm256_srli_epi32(cp, 18)),
+            _mm256_or_si256(_mm256_slli_epi32(c2, 8), _mm256_or_si256(_mm256_slli_epi32(c1, 16), _mm256_slli_epi32(c0, 24))));
+        return _mm256_blendv_epi8(_mm256_blendv_epi8(_mm256_blendv_epi8(cp, enc2, two_or_more), enc3, three_or_more),
+                                  enc4, four);
+    }
+
+    // See sse::utf8_pack_shuffle; each 128 bit half is packed on its own
+    inline UTF_CPP_TARGET_AVX2 __m256i utf8_pack_shuffle(__m256i ends)
+    {
+        const __m256i position = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                                  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const __m256i end0 = _mm256_shuffle_epi8(ends, _mm256_setzero_si256());
+        const __m256i end1 = _mm256_shuffle_epi8(ends, _mm256_set1_epi8(4));
+        const __m256i end2 = _mm256_shuffle_epi8(ends, _mm256_set1_epi8(8));
+        const __m256i past0 = _mm256_cmpeq_epi8(_mm256_max_epu8(position, end0), position);
+        const __m256i past1 = _mm256_cmpeq_epi8(_mm256_max_epu8(position, end1), position);
+        const __m256i past2 = _mm256_cmpeq_epi8(_mm256_max_epu8(position, end2), position);
+        const __m256i lane = _mm256_sub_epi8(_mm256_setzero_si256(), _mm256_add_epi8(_mm256_add_epi8(past0, past1), past2));
+        const __m256i lane_start = _mm256_max_epu8(_mm256_max_epu8(_mm256_and_si256(past0, end0), _mm256_and_si256(past1, end1)),
+                                                   _mm256_and_si256(past2, end2));
+        const __m256i lane_offset = _mm256_add_epi8(lane, lane);
+        return _mm256_add_epi8(_mm256_add_epi8(lane_offset, lane_offset), _mm256_sub_epi8(position, lane_start));
+    }
+
+    // UTF-16 -> UTF-8, as sse::utf16_to_utf8 with blocks of 32 ASCII units,
+    // 16 units below 0x800 or 8 arbitrary units
+    inline UTF_CPP_TARGET_AVX2 void utf16_to_utf8(const uint16_t*& in, const uint16_t* end,
+                                                 char*& out, char* out_end)
+    {
+        const uint16_t* it = in;
+        char* result = out;
+        while (end - it >= 32 && out_end - result >= 32) {
+            const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + 16));
+            if (_mm256_testz_si256(_mm256_or_si256(first, second), _mm256_set1_epi16(static_cast<short>(0xff80)))) {
+                // packus works within 128 bit halves
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(result),
+                                    _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xd8));
+                it += 32;
+                result += 32;
+                continue;
+            }
+            if (_mm256_testz_si256(first, _mm256_set1_epi16(static_cast<short>(0xf800)))) {
+                store_utf8_below_800(_mm256_castsi256_si128(first), result);
+                store_utf8_below_800(_mm256_extracti128_si256(first, 1), result);
+                it += 16;
+                continue;
+            }
+            const __m256i u = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(first));
+            const __m256i next = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 1)));
+            const __m256i surrogate_mask = _mm256_set1_epi32(0xfc00);
+            const __m256i lead = _mm256_cmpeq_epi32(_mm256_and_si256(u, surrogate_mask), _mm256_set1_epi32(0xd800));
+            const __m256i trail = _mm256_cmpeq_epi32(_mm256_and_si256(u, surrogate_mask), _mm256_set1_epi32(0xdc00));
+            const unsigned int lead_bits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(lead)));
+            const unsigned int trail_bits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(trail)));
+            __m256i cp = u;
+            if (lead_bits | trail_bits) {
+                const __m256i next_trail = _mm256_cmpeq_epi32(_mm256_and_si256(next, surrogate_mask), _mm256_set1_epi32(0xdc00));
+                const unsigned int next_trail_bits = static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(next_trail)));
+                if ((lead_bits & ~next_trail_bits) != 0 || trail_bits != ((lead_bits << 1) & 0xff))
+                    break;
+                const __m256i pair = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(u, 10), next),
+                                                      _mm256_set1_epi32(static_cast<int>(0xfca02400u)));
+                cp = _mm256_blendv_epi8(cp, pair, lead);
+            }
+            const __m256i two_or_more = _mm256_cmpgt_epi32(cp, _mm256_set1_epi32(0x7f));
+            const __m256i three_or_more = _mm256_cmpgt_epi32(cp, _mm256_set1_epi32(0x7ff));
+            const __m256i four = _mm256_cmpgt_epi32(cp, _mm256_set1_epi32(0xffff));
+            const __m256i length = _mm256_andnot_si256(trail, _mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(
+                _mm256_set1_epi32(1), two_or_more), three_or_more), four));
+            __m256i ends = _mm256_add_epi32(length, _mm256_slli_si256(length, 4));
+            ends = _mm256_add_epi32(ends, _mm256_slli_si256(ends, 8));
+            const __m256i packed = _mm256_shuffle_epi8(utf8_octets(cp, two_or_more, three_or_more, four), utf8_pack_shuffle(ends));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm256_castsi256_si128(packed));
+            result += _mm256_extract_epi32(ends, 3);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm256_extracti128_si256(packed, 1));
+            result += _mm256_extract_epi32(ends, 7);
+            it += 8 + (lead_bits >> 7);
+        }
+        in = it;
+        out = result;
+    }
+
+    // UTF-32 -> UTF-8, as sse::utf32_to_utf8 with blocks of 32 ASCII code
+    // points, 16 below 0x800 or 8 arbitrary ones
+    inline UTF_CPP_TARGET_AVX2 void utf32_to_utf8(const uint32_t*& in, const uint32_t* end,
+                                                 char*& out, char* out_end)
+    {
+        const uint32_t* it = in;
+        char* result = out;
+        while (end - it >= 32 && out_end - result >= 32) {
+            const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + 8));
+            const __m256i ab = _mm256_or_si256(a, b);
+            if (_mm256_testz_si256(ab, _mm256_set1_epi32(~0x7f))) {
+                const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + 16));
+                const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + 24));
+                if (_mm256_testz_si256(_mm256_or_si256(c, d), _mm256_set1_epi32(~0x7f))) {
+                    // The packs work within 128 bit halves, leaving the
+                    // groups of four octets interleaved
+                    const __m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(result),
+                                        _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+                    it += 32;
+                    result += 32;
+                    continue;
+                }
+            }
+            if (_mm256_testz_si256(ab, _mm256_set1_epi32(~0x7ff))) {
+                const __m256i units = _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), 0xd8);
+                store_utf8_below_800(_mm256_castsi256_si128(units), result);
+                store_utf8_below_800(_mm256_extracti128_si256(units, 1), result);
+                it += 16;
+                continue;
+            }
+            const __m256i cp = a;
+            const __m256i surrogate = _mm256_cmpeq_epi32(_mm256_and_si256(cp, _mm256_set1_epi32(static_cast<int>(0xfffff800u))),
+                                                         _mm256_set1_epi32(0xd800));
+            const __m256i in_range = _mm256_cmpeq_epi32(_mm256_min_epu32(cp, _mm256_set1_epi32(0x10ffff)), cp);
+            if (static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_andnot_si256(surrogate, in_range))) != 0xffffffffu)
+                break;
+            const __m256i two_or_more = _mm256_cmpgt_epi32(cp, _mm256_set1_epi32(0x7f));
+            const __m256i three_or_more = _mm256_cmpgt_epi32(cp, _mm256_set1_epi32(0x7ff));
+            const __m256i four = _mm256_cmpgt_epi32(cp, _mm256_set1_epi32(0xffff));
+            const __m256i length = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(
+                _mm256_set1_epi32(1), two_or_more), three_or_more), four);
+            __m256i ends = _mm256_add_epi32(length, _mm256_slli_si256(length, 4));
+            ends = _mm256_add_epi32(ends, _mm256_slli_si256(ends, 8));
+            const __m256i packed = _mm256_shuffle_epi8(utf8_octets(cp, two_or_more, three_or_more, four), utf8_pack_shuffle(ends));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm256_castsi256_si128(packed));
+            result += _mm256_extract_epi32(ends, 3);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm256_extracti128_si256(packed, 1));
+            result += _mm256_extract_epi32(ends, 7);
+            it += 8;
+        }
+        in = it;
+        out = result;
+    }
+
+    // Output lengths, as the sse:: counters with 32 byte blocks
+    inline UTF_CPP_TARGET_AVX2 unsigned int count_bits(__m256i mask)
+    {
+        return static_cast<unsigned int>(_mm_popcnt_u32(static_cast<unsigned int>(_mm256_movemask_epi8(mask))));
+    }
+
+    inline UTF_CPP_TARGET_AVX2 std::size_t utf32_length_from_utf8(const char*& in, const char* end)
+    {
+        const char* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 32; it += 32) {
+            const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            length += count_bits(_mm256_cmpgt_epi8(input, _mm256_set1_epi8(-65)));
+        }
+        in = it;
+        return length;
+    }
+
+    inline UTF_CPP_TARGET_AVX2 std::size_t utf16_length_from_utf8(const char*& in, const char* end)
+    {
+        const char* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 32; it += 32) {
+            const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const __m256i lead4 = _mm256_cmpeq_epi8(_mm256_max_epu8(input, _mm256_set1_epi8(static_cast<char>(0xf0))), input);
+            length += count_bits(_mm256_cmpgt_epi8(input, _mm256_set1_epi8(-65))) + count_bits(lead4);
+        }
+        in = it;
+        return length;
+    }
+
+    inline UTF_CPP_TARGET_AVX2 std::size_t utf8_length_from_utf16(const uint16_t*& in, const uint16_t* end)
+    {
+        const uint16_t* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 16; it += 16) {
+            const __m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const __m256i one = _mm256_cmpeq_epi16(_mm256_min_epu16(units, _mm256_set1_epi16(0x7f)), units);
+            const __m256i two = _mm256_cmpeq_epi16(_mm256_min_epu16(units, _mm256_set1_epi16(0x7ff)), units);
+            const __m256i surrogate = _mm256_cmpeq_epi16(_mm256_and_si256(units, _mm256_set1_epi16(static_cast<short>(0xf800))),
+                                                         _mm256_set1_epi16(static_cast<short>(0xd800)));
+            length += 48 - (count_bits(one) + count_bits(two) + count_bits(surrogate)) / 2;
+        }
+        in = it;
+        return length;
+    }
+
+    inline UTF_CPP_TARGET_AVX2 std::size_t utf8_length_from_utf32(const uint32_t*& in, const uint32_t* end)
+    {
+        const uint32_t* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 8; it += 8) {
+            const __m256i cp = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            const __m256i one = _mm256_cmpeq_epi32(_mm256_min_epu32(cp, _mm256_set1_epi32(0x7f)), cp);
+            const __m256i two = _mm256_cmpeq_epi32(_mm256_min_epu32(cp, _mm256_set1_epi32(0x7ff)), cp);
+            const __m256i three = _mm256_cmpeq_epi32(_mm256_min_epu32(cp, _mm256_set1_epi32(0xffff)), cp);
+            length += 32 - (count_bits(one) + count_bits(two) + count_bits(three)) / 4;
+        }
+        in = it;
+        return length;
+    }
+
+} // namespace utf8::internal::simd::avx2
+
+    UTF_CPP_SIMD_INLINE const implementation& avx2_implementation()
+    {
+        static const implementation impl = {"avx2", avx2::validate, avx2::utf8_to_utf16, avx2::utf16_to_utf8,
+                                            avx2::utf8_to_utf32, avx2::utf32_to_utf8,
+                                            avx2::utf16_length_from_utf8, avx2::utf32_length_from_utf8,
+                                            avx2::utf8_length_from_utf16, avx2::utf8_length_from_utf32,
+                                            avx2::latin1_to_utf8, avx2::utf8_to_latin1,
+                                            avx2::swap_bytes16, avx2::swap_bytes32};
+        return impl;
+    }
+
+} // namespace utf8::internal::simd
+} // namespace utf8::internal
+} // namespace utf8
+
+#endif // UTF_CPP_SIMD_X86
+
+#endif // header guard
@@ -0,0 +1,555 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_SIMD_AVX512_H_f33e2c3d_b75e_481d_88d7_8d03b88ce305
+#define UTF8_FOR_CPP_SIMD_AVX512_H_f33e2c3d_b75e_481d_88d7_8d03b88ce305
+
+#include "x86.h"
+
+#ifdef UTF_CPP_SIMD_X86
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define UTF_CPP_TARGET_AVX512
+    #define UTF_CPP_TARGET_AVX512_VBMI2
+#else
+    #define UTF_CPP_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,bmi,bmi2,popcnt")))
+    #define UTF_CPP_TARGET_AVX512_VBMI2 __attribute__((target("avx512f,avx512bw,avx512vl,avx512vbmi2,bmi,bmi2,popcnt")))
+#endif
+
+// GCC 12 warns about the _mm512_undefined_* placeholders inside its own
+// AVX-512 intrinsics once they are inlined
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic push
+    #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+    #pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+
+namespace utf8
+{
+namespace internal
+{
+namespace simd
+{
+// 64 bytes per step. The validator needs F, BW and VL; the transcoders
+// additionally use the VBMI2 compress instructions (Ice Lake and later).
+namespace avx512
+{
+    inline UTF_CPP_TARGET_AVX512 __m512i load_table(const unsigned char* table)
+    {
+        return _mm512_broadcast_i32x4(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+    }
+
+    inline UTF_CPP_TARGET_AVX512 __m512i high_nibbles(__m512i v)
+    {
+        return _mm512_and_si512(_mm512_srli_epi16(v, 4), _mm512_set1_epi8(0x0f));
+    }
+
+    // The bytes preceding each byte of input by 1, 2 or 3 positions
+    inline UTF_CPP_TARGET_AVX512 __m512i prev1(__m512i input, __m512i prev_input)
+    {
+        return _mm512_alignr_epi8(input, _mm512_alignr_epi64(input, prev_input, 6), 15);
+    }
+
+    inline UTF_CPP_TARGET_AVX512 __m512i prev2(__m512i input, __m512i prev_input)
+    {
+        return _mm512_alignr_epi8(input, _mm512_alignr_epi64(input, prev_input, 6), 14);
+    }
+
+    inline UTF_CPP_TARGET_AVX512 __m512i prev3(__m512i input, __m512i prev_input)
+    {
+        return _mm512_alignr_epi8(input, _mm512_alignr_epi64(input, prev_input, 6), 13);
+    }
+
+    inline UTF_CPP_TARGET_AVX512 __m512i check_special_cases(__m512i input, __m512i prev1)
+    {
+        const __m512i byte_1_high = _mm512_shuffle_epi8(load_table(byte_1_high_table), high_nibbles(prev1));
+        const __m512i byte_1_low  = _mm512_shuffle_epi8(load_table(byte_1_low_table),
+                                                        _mm512_and_si512(prev1, _mm512_set1_epi8(0x0f)));
+        const __m512i byte_2_high = _mm512_shuffle_epi8(load_table(byte_2_high_table), high_nibbles(input));
+        return _mm512_and_si512(_mm512_and_si512(byte_1_high, byte_1_low), byte_2_high);
+    }
+
+    inline UTF_CPP_TARGET_AVX512 __m512i check_multibyte_lengths(__m512i input, __m512i prev_input, __m512i special_cases)
+    {
+        const __m512i is_third_byte  = _mm512_subs_epu8(prev2(input, prev_input),
+                                                        _mm512_set1_epi8(static_cast<char>(0xe0u - 0x80u)));
+        const __m512i is_fourth_byte = _mm512_subs_epu8(prev3(input, prev_input),
+                                                        _mm512_set1_epi8(static_cast<char>(0xf0u - 0x80u)));
+        const __m512i must_be_trail = _mm512_and_si512(_mm512_or_si512(is_third_byte, is_fourth_byte),
+                                                       _mm512_set1_epi8(static_cast<char>(0x80)));
+        return _mm512_xor_si512(must_be_trail, special_cases);
+    }
+
+    inline UTF_CPP_TARGET_AVX512 __m512i incomplete_limits_512()
+    {
+        return _mm512_inserti32x4(_mm512_set1_epi8(static_cast<char>(0xff)),
+                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(incomplete_limits)), 3);
+    }
+
+    // Returns how far from start the input is known to be valid UTF-8; see resync()
+    inline UTF_CPP_TARGET_AVX512 const char* validate(const char* start, const char* end)
+    {
+        const __m512i limits = incomplete_limits_512();
+        __m512i prev_input = _mm512_setzero_si512();
+        __m512i prev_incomplete = _mm512_setzero_si512();
+        const char* it = start;
+        while (end - it >= 64) {
+            const __m512i input = _mm512_loadu_si512(it);
+            __m512i error;
+            if (_mm512_movepi8_mask(input) == 0) {
+                error = prev_incomplete;
+                prev_incomplete = _mm512_setzero_si512();
+            } else {
+                error = check_multibyte_lengths(input, prev_input,
+                                                check_special_cases(input, prev1(input, prev_input)));
+                prev_incomplete = _mm512_subs_epu8(input, limits);
+            }
+            if (_mm512_test_epi8_mask(error, error) != 0)
+                break;
+            prev_input = input;
+            it += 64;
+        }
+        return resync(start, it);
+    }
+
+    // UTF-8 -> UTF-16. Converts whole 64 byte blocks starting at in, as long
+    // as they are valid and out has room for 64 code units; stops on a
+    // sequence boundary, leaving the rest to the scalar code.
+    //
+    // Every sequence yields one code unit at its last octet; a four octet
+    // sequence also yields its lead surrogate at the third octet. The units
+    // are computed for all positions at once and then compressed.
+    inline UTF_CPP_TARGET_AVX512_VBMI2 void utf8_to_utf16(const char*& in, const char* end,
+                                                         uint16_t*& out, uint16_t* out_end)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i limits = incomplete_limits_512();
+        const char* it = in;
+        uint16_t* result = out;
+        while (end - it >= 64 && out_end - result >= 64) {
+            const __m512i input = _mm512_loadu_si512(it);
+            if (_mm512_movepi8_mask(input) == 0) {
+                _mm512_storeu_si512(result, _mm512_cvtepu8_epi16(_mm512_castsi512_si256(input)));
+                _mm512_storeu_si512(result + 32, _mm512_cvtepu8_epi16(_mm512_extracti64x4_epi64(input, 1)));
+                it += 64;
+                result += 64;
+                continue;
+            }
+            // it is on a sequence boundary, so the block is validated on its own
+            const __m512i input_1 = prev1(input, zero);
+            const __m512i input_2 = prev2(input, zero);
+            const __m512i error = check_multibyte_lengths(input, zero, check_special_cases(input, input_1));
+            if (_mm512_test_epi8_mask(error, error) != 0)
+                break;
+            // A sequence running past the block is left for the next round
+            const __mmask64 incomplete = _mm512_cmpgt_epu8_mask(input, limits);
+            const unsigned int length = incomplete ? static_cast<unsigned int>(_tzcnt_u64(incomplete)) : 64u;
+            const __mmask64 in_block = (length == 64) ? ~static_cast<__mmask64>(0) : ((static_cast<__mmask64>(1) << length) - 1);
+
+            const __mmask64 trail = _mm512_cmplt_epi8_mask(input, _mm512_set1_epi8(static_cast<char>(0xc0)));
+            const __mmask64 lead4 = _mm512_cmpge_epu8_mask(input, _mm512_set1_epi8(static_cast<char>(0xf0)));
+            const __mmask64 emit = (~(trail >> 1) | (lead4 << 2)) & in_block;
+            const __mmask64 two_end = trail & ~(trail << 1);
+            const __mmask64 three_end = trail & (trail << 1) & ~(trail << 2);
+            const __mmask64 lead_surrogate = lead4 << 2;
+            const __mmask64 trail_surrogate = trail & (trail << 1) & (trail << 2);
+
+            for (int half = 0; half < 2; ++half) {
+                const int shift = half * 32;
+                const __m512i w0 = _mm512_cvtepu8_epi16(half ? _mm512_extracti64x4_epi64(input, 1)   : _mm512_castsi512_si256(input));
+                const __m512i w1 = _mm512_cvtepu8_epi16(half ? _mm512_extracti64x4_epi64(input_1, 1) : _mm512_castsi512_si256(input_1));
+                const __m512i w2 = _mm512_cvtepu8_epi16(half ? _mm512_extracti64x4_epi64(input_2, 1) : _mm512_castsi512_si256(input_2));
+                const __m512i low6 = _mm512_set1_epi16(0x3f);
+                // Last two octets' payload; the lead of a two octet sequence has bit 5 clear
+                const __m512i t2 = _mm512_or_si512(_mm512_slli_epi16(_mm512_and_si512(w1, low6), 6), _mm512_and_si512(w0, low6));
+                // The 16 bit shift drops the 1110 prefix of a three octet lead
+                const __m512i t3 = _mm512_or_si512(_mm512_slli_epi16(w2, 12), t2);
+                const __m512i lead_sur = _mm512_add_epi16(_mm512_set1_epi16(static_cast<short>(0xd7c0)),
+                    _mm512_srli_epi16(_mm512_or_si512(_mm512_slli_epi16(_mm512_and_si512(w2, _mm512_set1_epi16(0x07)), 12), t2), 4));
+                const __m512i trail_sur = _mm512_or_si512(_mm512_set1_epi16(static_cast<short>(0xdc00)),
+                                                          _mm512_and_si512(t2, _mm512_set1_epi16(0x3ff)));
+                __m512i units = w0;
+                units = _mm512_mask_mov_epi16(units, static_cast<__mmask32>(two_end >> shift), t2);
+                units = _mm512_mask_mov_epi16(units, static_cast<__mmask32>(three_end >> shift), t3);
+                units = _mm512_mask_mov_epi16(units, static_cast<__mmask32>(lead_surrogate >> shift), lead_sur);
+                units = _mm512_mask_mov_epi16(units, static_cast<__mmask32>(trail_surrogate >> shift), trail_sur);
+
+                const __mmask32 keep = static_cast<__mmask32>(emit >> shift);
+                const unsigned int count = static_cast<unsigned int>(_mm_popcnt_u32(keep));
+                const __mmask32 store = (count == 32) ? ~static_cast<__mmask32>(0) : ((static_cast<__mmask32>(1) << count) - 1);
+                _mm512_mask_storeu_epi16(result, store, _mm512_maskz_compress_epi16(keep, units));
+                result += count;
+            }
+            it += length;
+        }
+        in = it;
+        out = result;
+    }
+
+    // The 128 bit quarter of v at index; the extract takes an immediate
+    inline UTF_CPP_TARGET_AVX512 __m128i quarter_of(__m512i v, int index)
+    {
+        switch (index) {
+            case 1:  return _mm512_extracti32x4_epi32(v, 1);
+            case 2:  return _mm512_extracti32x4_epi32(v, 2);
+            case 3:  return _mm512_extracti32x4_epi32(v, 3);
+            default: return _mm512_castsi512_si128(v);
+        }
+    }
+
+    // UTF-8 -> UTF-32, as utf8_to_utf16 with every sequence, four octet
+    // ones included, yielding its code point at its last octet. Only needs
+    // AVX-512F/BW: 32 bit lanes can be compressed without VBMI2.
+    inline UTF_CPP_TARGET_AVX512 void utf8_to_utf32(const char*& in, const char* end,
+                                                   uint32_t*& out, uint32_t* out_end)
+    {
+        const __m512i zero = _mm512_setzero_si512();
+        const __m512i limits = incomplete_limits_512();
+        const char* it = in;
+        uint32_t* result = out;
+        while (end - it >= 64 && out_end - result >= 64) {
+            const __m512i input = _mm512_loadu_si512(it);
+            if (_mm512_movepi8_mask(input) == 0) {
+                for (int quarter = 0; quarter < 4; ++quarter)
+                    _mm512_storeu_si512(result + quarter * 16, _mm512_cvtepu8_epi32(quarter_of(input, quarter)));
+                it += 64;
+                result += 64;
+                continue;
+            }
+            // it is on a sequence boundary, so the block is validated on its own
+            const __m512i input_1 = prev1(input, zero);
+            const __m512i input_2 = prev2(input, zero);
+            const __m512i input_3 = prev3(input, zero);
+            const __m512i error = check_multibyte_lengths(input, zero, check_special_cases(input, input_1));
+            if (_mm512_test_epi8_mask(error, error) != 0)
+                break;
+            // A sequence running past the block is left for the next round
+            const __mmask64 incomplete = _mm512_cmpgt_epu8_mask(input, limits);
+            const unsigned int length = incomplete ? static_cast<unsigned int>(_tzcnt_u64(incomplete)) : 64u;
+            const __mmask64 in_block = (length == 64) ? ~static_cast<__mmask64>(0) : ((static_cast<__mmask64>(1) << length) - 1);
+
+            const __mmask64 trail = _mm512_cmplt_epi8_mask(input, _mm512_set1_epi8(static_cast<char>(0xc0)));
+            const __mmask64 emit = ~(trail >> 1) & in_block;
+            const __mmask64 two_end = trail & ~(trail << 1);
+            const __mmask64 three_end = trail & (trail << 1) & ~(trail << 2);
+            const __mmask64 four_end = trail & (trail << 1) & (trail << 2);
+
+            for (int quarter = 0; quarter < 4; ++quarter) {
+                const int shift = quarter * 16;
+                const __m512i w0 = _mm512_cvtepu8_epi32(quarter_of(input, quarter));
+                const __m512i w1 = _mm512_cvtepu8_epi32(quarter_of(input_1, quarter));
+                const __m512i w2 = _mm512_cvtepu8_epi32(quarter_of(input_2, quarter));
+                const __m512i w3 = _mm512_cvtepu8_epi32(quarter_of(input_3, quarter));
+                const __m512i low6 = _mm512_set1_epi32(0x3f);
+                const __m512i t2 = _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(w1, low6), 6), _mm512_and_si512(w0, low6));
+                const __m512i t3 = _mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(w2, _mm512_set1_epi32(0x0f)), 12), t2);
+                const __m512i t4 = _mm512_or_si512(_mm512_or_si512(_mm512_slli_epi32(_mm512_and_si512(w3, _mm512_set1_epi32(0x07)), 18),
+                                                                   _mm512_slli_epi32(_mm512_and_si512(w2, low6), 12)), t2);
+                __m512i units = w0;
+                units = _mm512_mask_mov_epi32(units, static_cast<__mmask16>(two_end >> shift), t2);
+                units = _mm512_mask_mov_epi32(units, static_cast<__mmask16>(three_end >> shift), t3);
+                units = _mm512_mask_mov_epi32(units, static_cast<__mmask16>(four_end >> shift), t4);
+
+                const __mmask16 keep = static_cast<__mmask16>(emit >> shift);
+                _mm512_mask_compressstoreu_epi32(result, keep, units);
+                result += _mm_popcnt_u32(keep);
+            }
+            it += length;
+        }
+        in = it;
+        out = result;
+    }
+
+    // UTF-16 -> UTF-8. Converts blocks of 32 ASCII units or 16 arbitrary
+    // units, as long as they are valid and out has room for 64 octets; stops
+    // before a lone surrogate. A lead surrogate ending a block is carried over
+    // to the next one.
+    //
+    // Each code point is encoded into its own 32 bit lane, then the unused
+    // octets are compressed out.
+    inline UTF_CPP_TARGET_AVX512_VBMI2 void utf16_to_utf8(const uint16_t*& in, const uint16_t* end,
+                                                         char*& out, char* out_end)
+    {
+        const uint16_t* it = in;
+        char* result = out;
+        while (end - it >= 16 && out_end - result >= 64) {
+            if (end - it >= 32) {
+                const __m512i units = _mm512_loadu_si512(it);
+                if (_mm512_cmpge_epu16_mask(units, _mm512_set1_epi16(0x80)) == 0) {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(result), _mm512_cvtepi16_epi8(units));
+                    it += 32;
+                    result += 32;
+                    continue;
+                }
+            }
+            const __m512i u = _mm512_cvtepu16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it)));
+            __m512i cp = u;
+            __mmask16 in_block = 0xffff;
+            __mmask16 trail_sur = 0;
+            const __m512i surrogate_bits = _mm512_and_si512(u, _mm512_set1_epi32(0xfc00));
+            const __mmask16 lead_sur = _mm512_cmpeq_epi32_mask(surrogate_bits, _mm512_set1_epi32(0xd800));
+            trail_sur = _mm512_cmpeq_epi32_mask(surrogate_bits, _mm512_set1_epi32(0xdc00));
+            if (lead_sur | trail_sur) {
+                if (lead_sur & 0x8000)
+                    in_block = 0x7fff;
+                // Each lead surrogate must be followed by a trail surrogate, and vice versa
+                if (static_cast<__mmask16>((lead_sur & in_block) << 1) != (trail_sur & in_block))
+                    break;
+                const __m512i next = _mm512_alignr_epi32(_mm512_setzero_si512(), u, 1);
+                const __m512i pair = _mm512_add_epi32(_mm512_add_epi32(_mm512_slli_epi32(u, 10), next),
+                                                      _mm512_set1_epi32(static_cast<int>(0xfca02400u)));
+                cp = _mm512_mask_mov_epi32(cp, lead_sur, pair);
+            }
+            const __mmask16 two_or_more = _mm512_cmpge_epu32_mask(cp, _mm512_set1_epi32(0x80));
+            const __mmask16 three_or_more = _mm512_cmpge_epu32_mask(cp, _mm512_set1_epi32(0x800));
+            const __mmask16 four = _mm512_cmpge_epu32_mask(cp, _mm512_set1_epi32(0x10000));
+
+            const __m512i low6 = _mm512_set1_epi32(0x3f);
+            const __m512i cont = _mm512_set1_epi32(0x80);
+            const __m512i c0 = _mm512_or_si512(cont, _mm512_and_si512(cp, low6));
+            const __m512i c1 = _mm512_or_si512(cont, _mm512_and_si512(_mm512_srli_epi32(cp, 6), low6));
+            const __m512i c2 = _mm512_or_si512(cont, _mm512_and_si512(_mm512_srli_epi32(cp, 12), low6));
+            const __m512i enc2 = _mm512_or_si512(_mm512_or_si512(_mm512_set1_epi32(0xc0), _mm512_srli_epi32(cp, 6)),
+                                                 _mm512_slli_epi32(c0, 8));
+            const __m512i enc3 = _mm512_or_si512(_mm512_or_si512(_mm512_set1_epi32(0xe0), _mm512_srli_epi32(cp, 12)),
+                                                 _mm512_or_si512(_mm512_slli_epi32(c1, 8), _mm512_slli_epi32(c0, 16)));
+            const __m512i enc4 = _mm512_or_si512(
+                _mm512_or_si512(_mm512_set1_epi32(0xf0), _mm512_srli_epi32(cp, 18)),
+                _mm512_or_si512(_mm512_slli_epi32(c2, 8), _mm512_or_si512(_mm512_slli_epi32(c1, 16), _mm512_slli_epi32(c0, 24))));
+            __m512i encoded = cp;
+            encoded = _mm512_mask_mov_epi32(encoded, two_or_more, enc2);
+            encoded = _mm512_mask_mov_epi32(encoded, three_or_more, enc3);
+            encoded = _mm512_mask_mov_epi32(encoded, four, enc4);
+
+            // Octet count per lane; trail surrogates were encoded with their leads
+            __m512i length = _mm512_set1_epi32(1);
+            length = _mm512_mask_add_epi32(length, two_or_more, length, _mm512_set1_epi32(1));
+            length = _mm512_mask_add_epi32(length, three_or_more, length, _mm512_set1_epi32(1));
+            length = _mm512_mask_add_epi32(length, four, length, _mm512_set1_epi32(1));
+            length = _mm512_maskz_mov_epi32(static_cast<__mmask16>(in_block & ~trail_sur), length);
+            const __m512i length_bytes = _mm512_mullo_epi32(length, _mm512_set1_epi32(0x01010101));
+            const __mmask64 keep = _mm512_cmplt_epu8_mask(_mm512_set1_epi32(0x03020100), length_bytes);
+
+            const unsigned int count = static_cast<unsigned int>(_mm_popcnt_u64(keep));
+            _mm512_mask_storeu_epi8(result, (static_cast<__mmask64>(1) << count) - 1, _mm512_maskz_compress_epi8(keep, encoded));
+            result += count;
+            it += (in_block == 0xffff) ? 16 : 15;
+        }
+        in = it;
+        out = result;
+    }
+
+    // UTF-32 -> UTF-8. Converts blocks of 16 code points, as long as out has
+    // room for 64 octets; stops before a surrogate or a value above 0x10ffff.
+    // Encoded as in utf16_to_utf8.
+    inline UTF_CPP_TARGET_AVX512_VBMI2 void utf32_to_utf8(const uint32_t*& in, const uint32_t* end,
+                                                         char*& out, char* out_end)
+    {
+        const uint32_t* it = in;
+        char* result = out;
+        while (end - it >= 16 && out_end - result >= 64) {
+            const __m512i cp = _mm512_loadu_si512(it);
+            const __mmask16 two_or_more = _mm512_cmpge_epu32_mask(cp, _mm512_set1_epi32(0x80));
+            if (two_or_more == 0) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm512_cvtepi32_epi8(cp));
+                it += 16;
+                result += 16;
+                continue;
+            }
+            // Up to the first invalid code point
+            const __mmask16 invalid = _mm512_cmpgt_epu32_mask(cp, _mm512_set1_epi32(0x10ffff))
+                | _mm512_cmpeq_epi32_mask(_mm512_and_si512(cp, _mm512_set1_epi32(static_cast<int>(0xfffff800u))),
+                                          _mm512_set1_epi32(0xd800));
+            const unsigned int count_in = invalid ? static_cast<unsigned int>(_tzcnt_u32(invalid)) : 16u;
+            if (count_in == 0)
+                break;
+            const __mmask16 in_block = static_cast<__mmask16>((1u << count_in) - 1);
+            const __mmask16 three_or_more = _mm512_cmpge_epu32_mask(cp, _mm512_set1_epi32(0x800));
+            const __mmask16 four = _mm512_cmpge_epu32_mask(cp, _mm512_set1_epi32(0x10000));
+
+            const __m512i low6 = _mm512_set1_epi32(0x3f);
+            const __m512i cont = _mm512_set1_epi32(0x80);
+            const __m512i c0 = _mm512_or_si512(cont, _mm512_and_si512(cp, low6));
+            const __m512i c1 = _mm512_or_si512(cont, _mm512_and_si512(_mm512_srli_epi32(cp, 6), low6));
+            const __m512i c2 = _mm512_or_si512(cont, _mm512_and_si512(_mm512_srli_epi32(cp, 12), low6));
+            const __m512i enc2 = _mm512_or_si512(_mm512_or_si512(_mm512_set1_epi32(0xc0), _mm512_srli_epi32(cp, 6)),
+                                                 _mm512_slli_epi32(c0, 8));
+            const __m512i enc3 = _mm512_or_si512(_mm512_or_si512(_mm512_set1_epi32(0xe0), _mm512_srli_epi32(cp, 12)),
+                                                 _mm512_or_si512(_mm512_slli_epi32(c1, 8), _mm512_slli_epi32(c0, 16)));
+            const __m512i enc4 = _mm512_or_si512(
+                _mm512_or_si512(_mm512_set1_epi32(0xf0), _mm512_srli_epi32(cp, 18)),
+                _mm512_or_si512(_mm512_slli_epi32(c2, 8), _mm512_or_si512(_mm512_slli_epi32(c1, 16), _mm512_slli_epi32(c0, 24))));
+            __m512i encoded = cp;
+            encoded = _mm512_mask_mov_epi32(encoded, two_or_more, enc2);
+            encoded = _mm512_mask_mov_epi32(encoded, three_or_more, enc3);
+            encoded = _mm512_mask_mov_epi32(encoded, four, enc4);
+
+            __m512i length = _mm512_set1_epi32(1);
+            length = _mm512_mask_add_epi32(length, two_or_more, length, _mm512_set1_epi32(1));
+            length = _mm512_mask_add_epi32(length, three_or_more, length, _mm512_set1_epi32(1));
+            length = _mm512_mask_add_epi32(length, four, length, _mm512_set1_epi32(1));
+            length = _mm512_maskz_mov_epi32(in_block, length);
+            const __m512i length_bytes = _mm512_mullo_epi32(length, _mm512_set1_epi32(0x01010101));
+            const __mmask64 keep = _mm512_cmplt_epu8_mask(_mm512_set1_epi32(0x03020100), length_bytes);
+
+            const unsigned int count = static_cast<unsigned int>(_mm_popcnt_u64(keep));
+            const __mmask64 store = (count == 64) ? ~static_cast<__mmask64>(0) : ((static_cast<__mmask64>(1) << count) - 1);
+            _mm512_mask_storeu_epi8(result, store, _mm512_maskz_compress_epi8(keep, encoded));
+            result += count;
+            it += count_in;
+        }
+        in = it;
+        out = result;
+    }
+
+    // Latin-1 -> UTF-8. Converts blocks of 32 octets, as long as out has room
+    // for 64 octets. Each octet is widened to 16 bits and encoded in place as
+    // one or two octets; the second octet is dropped by the compress for the
+    // ASCII ones.
+    inline UTF_CPP_TARGET_AVX512_VBMI2 void latin1_to_utf8(const char*& in, const char* end,
+                                                          char*& out, char* out_end)
+    {
+        // The first octet of each 16 bit lane is always kept
+        const __mmask64 first = (static_cast<__mmask64>(0x55555555u) << 32) | 0x55555555u;
+        const char* it = in;
+        char* result = out;
+        while (end - it >= 32 && out_end - result >= 64) {
+            const __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+            if (_mm256_movemask_epi8(input) == 0) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(result), input);
+                it += 32;
+                result += 32;
+                continue;
+            }
+            const __m512i c = _mm512_cvtepu8_epi16(input);
+            const __mmask32 two = _mm512_cmpge_epu16_mask(c, _mm512_set1_epi16(0x80));
+            const __m512i enc2 = _mm512_or_si512(
+                _mm512_or_si512(_mm512_set1_epi16(0xc0), _mm512_srli_epi16(c, 6)),
+                _mm512_slli_epi16(_mm512_or_si512(_mm512_set1_epi16(0x80), _mm512_and_si512(c, _mm512_set1_epi16(0x3f))), 8));
+            const __m512i encoded = _mm512_mask_mov_epi16(c, two, enc2);
+            const __mmask64 keep = _mm512_test_epi8_mask(encoded, encoded) | first;
+
+            const unsigned int count = static_cast<unsigned int>(_mm_popcnt_u64(keep));
+            const __mmask64 store = (count == 64) ? ~static_cast<__mmask64>(0) : ((static_cast<__mmask64>(1) << count) - 1);
+            _mm512_mask_storeu_epi8(result, store, _mm512_maskz_compress_epi8(keep, encoded));
+            result += count;
+            it += 32;
+        }
+        in = it;
+        out = result;
+    }
+
+    // Output lengths, as the sse:: counters with 64 byte blocks
+    inline UTF_CPP_TARGET_AVX512 std::size_t utf32_length_from_utf8(const char*& in, const char* end)
+    {
+        const char* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 64; it += 64) {
+            const __m512i input = _mm512_loadu_si512(it);
+            length += static_cast<std::size_t>(_mm_popcnt_u64(_mm512_cmpgt_epi8_mask(input, _mm512_set1_epi8(-65))));
+        }
+        in = it;
+        return length;
+    }
+
+    inline UTF_CPP_TARGET_AVX512 std::size_t utf16_length_from_utf8(const char*& in, const char* end)
+    {
+        const char* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 64; it += 64) {
+            const __m512i input = _mm512_loadu_si512(it);
+            length += static_cast<std::size_t>(_mm_popcnt_u64(_mm512_cmpgt_epi8_mask(input, _mm512_set1_epi8(-65)))
+                + _mm_popcnt_u64(_mm512_cmpge_epu8_mask(input, _mm512_set1_epi8(static_cast<char>(0xf0)))));
+        }
+        in = it;
+        return length;
+    }
+
+    inline UTF_CPP_TARGET_AVX512 std::size_t utf8_length_from_utf16(const uint16_t*& in, const uint16_t* end)
+    {
+        const uint16_t* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 32; it += 32) {
+            const __m512i units = _mm512_loadu_si512(it);
+            const __mmask32 one = _mm512_cmplt_epu16_mask(units, _mm512_set1_epi16(0x80));
+            const __mmask32 two = _mm512_cmplt_epu16_mask(units, _mm512_set1_epi16(0x800));
+            const __mmask32 surrogate = _mm512_cmpeq_epi16_mask(_mm512_and_si512(units, _mm512_set1_epi16(static_cast<short>(0xf800))),
+                                                                _mm512_set1_epi16(static_cast<short>(0xd800)));
+            length += static_cast<std::size_t>(96 - _mm_popcnt_u32(one) - _mm_popcnt_u32(two) - _mm_popcnt_u32(surrogate));
+        }
+        in = it;
+        return length;
+    }
+
+    inline UTF_CPP_TARGET_AVX512 std::size_t utf8_length_from_utf32(const uint32_t*& in, const uint32_t* end)
+    {
+        const uint32_t* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 16; it += 16) {
+            const __m512i cp = _mm512_loadu_si512(it);
+            const __mmask16 one = _mm512_cmplt_epu32_mask(cp, _mm512_set1_epi32(0x80));
+            const __mmask16 two = _mm512_cmplt_epu32_mask(cp, _mm512_set1_epi32(0x800));
+            const __mmask16 three = _mm512_cmplt_epu32_mask(cp, _mm512_set1_epi32(0x10000));
+            length += static_cast<std::size_t>(64 - _mm_popcnt_u32(one) - _mm_popcnt_u32(two) - _mm_popcnt_u32(three));
+        }
+        in = it;
+        return length;
+    }
+
+} // namespace utf8::internal::simd::avx512
+
+    UTF_CPP_SIMD_INLINE const implementation& avx512_implementation()
+    {
+        static const implementation impl = {"avx512", avx512::validate, 0, 0, avx512::utf8_to_utf32, 0,
+                                            avx512::utf16_length_from_utf8, avx512::utf32_length_from_utf8,
+                                            avx512::utf8_length_from_utf16, avx512::utf8_length_from_utf32,
+                                            0, 0, 0, 0};
+        return impl;
+    }
+
+    UTF_CPP_SIMD_INLINE const implementation& avx512_vbmi2_implementation()
+    {
+        static const implementation impl = {"avx512-vbmi2", avx512::validate,
+                                            avx512::utf8_to_utf16, avx512::utf16_to_utf8,
+                                            avx512::utf8_to_utf32, avx512::utf32_to_utf8,
+                                            avx512::utf16_length_from_utf8, avx512::utf32_length_from_utf8,
+                                            avx512::utf8_length_from_utf16, avx512::utf8_length_from_utf32,
+                                            avx512::latin1_to_utf8, 0, 0, 0};
+        return impl;
+    }
+
+} // namespace utf8::internal::simd
+} // namespace utf8::internal
+} // namespace utf8
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic pop
+#endif
+
+#endif // UTF_CPP_SIMD_X86
+
+#endif // header guard
@@ -0,0 +1,171 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_SIMD_CPU_H_1e2dee55_0522_4bdf_aaa0_c86e8ec4542a
+#define UTF8_FOR_CPP_SIMD_CPU_H_1e2dee55_0522_4bdf_aaa0_c86e8ec4542a
+
+#include "x86.h"
+
+#ifdef UTF_CPP_SIMD_X86
+
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#else
+    #include <cpuid.h>
+#endif
+
+namespace utf8
+{
+namespace internal
+{
+namespace simd
+{
+    // Instruction set extensions the kernels are built for
+    enum cpu_feature {
+        CPU_SSE42        = 1 << 0, // with SSSE3, SSE4.1 and POPCNT
+        CPU_AVX2         = 1 << 1, // with BMI1 and BMI2
+        CPU_AVX512       = 1 << 2, // F, BW and VL
+        CPU_AVX512_VBMI2 = 1 << 3
+    };
+
+    inline void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4])
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i)
+            regs[i] = static_cast<unsigned int>(info[i]);
+#else
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    // The register state the OS saves on context switches (XCR0)
+    inline uint64_t os_saved_state()
+    {
+#if defined(_MSC_VER)
+        return _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+    }
+
+    inline int detect_cpu_features()
+    {
+        unsigned int regs[4];
+        cpuid(0, 0, regs);
+        const unsigned int max_leaf = regs[0];
+        if (max_leaf < 1)
+            return 0;
+
+        cpuid(1, 0, regs);
+        const unsigned int leaf1_ecx = regs[2];
+        int features = 0;
+        const unsigned int sse42_bits = (1u << 9) | (1u << 19) | (1u << 20) | (1u << 23); // SSSE3, SSE4.1, SSE4.2, POPCNT
+        if ((leaf1_ecx & sse42_bits) == sse42_bits)
+            features |= CPU_SSE42;
+
+        // AVX and AVX-512 need the OS to preserve the wider registers
+        const bool osxsave = (leaf1_ecx & (1u << 27)) != 0;
+        if (!osxsave || max_leaf < 7)
+            return features;
+        const uint64_t xcr0 = os_saved_state();
+        const bool os_avx = (xcr0 & 0x6) == 0x6;
+        const bool os_avx512 = os_avx && (xcr0 & 0xe0) == 0xe0;
+
+        cpuid(7, 0, regs);
+        const unsigned int leaf7_ebx = regs[1];
+        const unsigned int leaf7_ecx = regs[2];
+        const unsigned int avx2_bits = (1u << 3) | (1u << 5) | (1u << 8); // BMI1, AVX2, BMI2
+        if (os_avx && (features & CPU_SSE42) && (leaf7_ebx & avx2_bits) == avx2_bits)
+            features |= CPU_AVX2;
+        const unsigned int avx512_bits = (1u << 16) | (1u << 30) | (1u << 31); // F, BW, VL
+        if (os_avx512 && (features & CPU_AVX2) && (leaf7_ebx & avx512_bits) == avx512_bits) {
+            features |= CPU_AVX512;
+            if (leaf7_ecx & (1u << 6))
+                features |= CPU_AVX512_VBMI2;
+        }
+        return features;
+    }
+
+    inline const char* environment_setting(const char* name)
+    {
+#if defined(_MSC_VER)
+    #pragma warning(push)
+    #pragma warning(disable: 4996) // getenv is not thread-safe in general; we only read it once
+#endif
+        return std::getenv(name);
+#if defined(_MSC_VER)
+    #pragma warning(pop)
+#endif
+    }
+
+    // Setting the UTF8CPP_DISABLE_SIMD environment variable to anything but
+    // an empty string or "0" keeps all the code paths scalar
+    inline bool simd_disabled_by_environment()
+    {
+        const char* setting = environment_setting("UTF8CPP_DISABLE_SIMD");
+        return setting != 0 && *setting != '\0' && !(setting[0] == '0' && setting[1] == '\0');
+    }
+
+    // UTF8CPP_SIMD_IMPLEMENTATION names the widest set of kernels to use
+    // ("scalar", "sse4.2", "avx2", "avx512" or "avx512-vbmi2"), so that the
+    // narrower ones can be tested on newer CPUs as well
+    inline int features_allowed_by_environment()
+    {
+        if (simd_disabled_by_environment())
+            return 0;
+        const char* setting = environment_setting("UTF8CPP_SIMD_IMPLEMENTATION");
+        if (setting == 0 || *setting == '\0')
+            return ~0;
+        const char* const names[] = {"scalar", "sse4.2", "avx2", "avx512", "avx512-vbmi2"};
+        for (int i = 0; i < 5; ++i) {
+            if (std::strcmp(setting, names[i]) == 0)
+                return (1 << i) - 1;
+        }
+        return ~0;
+    }
+
+    // Detected on first use; the result never changes afterwards
+    inline int cpu_features()
+    {
+        static const int features = detect_cpu_features() & features_allowed_by_environment();
+        return features;
+    }
+
+} // namespace utf8::internal::simd
+} // namespace utf8::internal
+} // namespace utf8
+
+#endif // UTF_CPP_SIMD_X86
+
+#endif // header guard
@@ -0,0 +1,118 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_SIMD_DISPATCH_H_7c1d7a4e_3b5f_4f0e_9a1c_52d8e6b0f914
+#define UTF8_FOR_CPP_SIMD_DISPATCH_H_7c1d7a4e_3b5f_4f0e_9a1c_52d8e6b0f914
+
+#include "cpu.h"
+#include "implementation.h"
+
+#if defined(UTF_CPP_SIMD_X86) && !defined(UTF_CPP_SIMD_LIBRARY)
+    #include "sse.h"
+    #include "avx2.h"
+    #include "avx512.h"
+#endif
+
+namespace utf8
+{
+namespace internal
+{
+namespace simd
+{
+#if defined(UTF_CPP_SIMD_X86) && defined(UTF_CPP_SIMD_LIBRARY)
+    // Defined in the utf8cpp::simd library, one translation unit per instruction set
+    const implementation& sse42_implementation();
+    const implementation& avx2_implementation();
+    const implementation& avx512_implementation();
+    const implementation& avx512_vbmi2_implementation();
+#endif
+
+    // A tier without a kernel of its own uses the one of the tier below
+    inline implementation fill_in(implementation tier, const implementation& below)
+    {
+        if (!tier.validate)
+            tier.validate = below.validate;
+        if (!tier.utf8_to_utf16)
+            tier.utf8_to_utf16 = below.utf8_to_utf16;
+        if (!tier.utf16_to_utf8)
+            tier.utf16_to_utf8 = below.utf16_to_utf8;
+        if (!tier.utf8_to_utf32)
+            tier.utf8_to_utf32 = below.utf8_to_utf32;
+        if (!tier.utf32_to_utf8)
+            tier.utf32_to_utf8 = below.utf32_to_utf8;
+        if (!tier.utf16_length_from_utf8)
+            tier.utf16_length_from_utf8 = below.utf16_length_from_utf8;
+        if (!tier.utf32_length_from_utf8)
+            tier.utf32_length_from_utf8 = below.utf32_length_from_utf8;
+        if (!tier.utf8_length_from_utf16)
+            tier.utf8_length_from_utf16 = below.utf8_length_from_utf16;
+        if (!tier.utf8_length_from_utf32)
+            tier.utf8_length_from_utf32 = below.utf8_length_from_utf32;
+        if (!tier.latin1_to_utf8)
+            tier.latin1_to_utf8 = below.latin1_to_utf8;
+        if (!tier.utf8_to_latin1)
+            tier.utf8_to_latin1 = below.utf8_to_latin1;
+        if (!tier.swap_bytes16)
+            tier.swap_bytes16 = below.swap_bytes16;
+        if (!tier.swap_bytes32)
+            tier.swap_bytes32 = below.swap_bytes32;
+        return tier;
+    }
+
+    inline implementation select_implementation()
+    {
+        implementation impl = scalar_implementation();
+#ifdef UTF_CPP_SIMD_X86
+        // Each feature implies the ones before it
+        const int features = cpu_features();
+        if (features & CPU_SSE42)
+            impl = fill_in(sse42_implementation(), impl);
+        if (features & CPU_AVX2)
+            impl = fill_in(avx2_implementation(), impl);
+        if (features & CPU_AVX512)
+            impl = fill_in(avx512_implementation(), impl);
+        if (features & CPU_AVX512_VBMI2)
+            impl = fill_in(avx512_vbmi2_implementation(), impl);
+#endif
+        return impl;
+    }
+
+    // Selected on first use. The initialization of the local static is
+    // thread-safe (C++11 "magic statics", and GCC and Clang in C++98 mode
+    // too); at worst, racing threads of an older compiler select the same
+    // kernels more than once.
+    inline const implementation& active()
+    {
+        static const implementation impl = select_implementation();
+        return impl;
+    }
+
+} // namespace utf8::internal::simd
+} // namespace utf8::internal
+} // namespace utf8
+
+#endif // header guard
@@ -0,0 +1,100 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_SIMD_IMPLEMENTATION_H_0b8e3f2a_9d61_4c57_8e0f_6a4d2c91b7e3
+#define UTF8_FOR_CPP_SIMD_IMPLEMENTATION_H_0b8e3f2a_9d61_4c57_8e0f_6a4d2c91b7e3
+
+#include <stdint.h>
+#include <cstddef>
+
+// The tables of kernels are defined in the kernel headers. With the compiled
+// utf8cpp::simd library (UTF_CPP_SIMD_LIBRARY), they are compiled once, in
+// the library's own translation units, and the headers are not included
+// anywhere else.
+#ifdef UTF_CPP_SIMD_LIBRARY
+    #define UTF_CPP_SIMD_INLINE
+#else
+    #define UTF_CPP_SIMD_INLINE inline
+#endif
+
+namespace utf8
+{
+namespace internal
+{
+namespace simd
+{
+    // Kernel signatures. A validator returns how far from start the input is
+    // known to be valid; a transcoder advances in and out past what it has
+    // converted, never writing at or beyond out_end. See the kernel headers.
+    // The code units are plain integers rather than utfchar16_t/utfchar32_t,
+    // which depend on the C++ standard in use.
+    typedef const char* (*validate_kernel)(const char* start, const char* end);
+    typedef void (*utf8_to_utf16_kernel)(const char*& in, const char* end, uint16_t*& out, uint16_t* out_end);
+    typedef void (*utf16_to_utf8_kernel)(const uint16_t*& in, const uint16_t* end, char*& out, char* out_end);
+    typedef void (*utf8_to_utf32_kernel)(const char*& in, const char* end, uint32_t*& out, uint32_t* out_end);
+    typedef void (*utf32_to_utf8_kernel)(const uint32_t*& in, const uint32_t* end, char*& out, char* out_end);
+    // A counter returns the output length of the whole blocks it advances in
+    // past; the length of what is left is up to the caller
+    typedef std::size_t (*utf8_count_kernel)(const char*& in, const char* end);
+    typedef std::size_t (*utf16_count_kernel)(const uint16_t*& in, const uint16_t* end);
+    typedef std::size_t (*utf32_count_kernel)(const uint32_t*& in, const uint32_t* end);
+    // Latin-1 in and out, one octet per code point
+    typedef void (*latin1_to_utf8_kernel)(const char*& in, const char* end, char*& out, char* out_end);
+    typedef void (*utf8_to_latin1_kernel)(const char*& in, const char* end, char*& out, char* out_end);
+    // Reverse the bytes of each code unit in place, for the other byte order
+    typedef void (*swap_bytes16_kernel)(uint16_t*& units, const uint16_t* end);
+    typedef void (*swap_bytes32_kernel)(uint32_t*& units, const uint32_t* end);
+
+    // The kernels for one instruction set; the scalar code covers the null entries
+    struct implementation {
+        const char*          name;
+        validate_kernel      validate;
+        utf8_to_utf16_kernel utf8_to_utf16;
+        utf16_to_utf8_kernel utf16_to_utf8;
+        utf8_to_utf32_kernel utf8_to_utf32;
+        utf32_to_utf8_kernel utf32_to_utf8;
+        utf8_count_kernel    utf16_length_from_utf8;
+        utf8_count_kernel    utf32_length_from_utf8;
+        utf16_count_kernel   utf8_length_from_utf16;
+        utf32_count_kernel   utf8_length_from_utf32;
+        latin1_to_utf8_kernel latin1_to_utf8;
+        utf8_to_latin1_kernel utf8_to_latin1;
+        swap_bytes16_kernel  swap_bytes16;
+        swap_bytes32_kernel  swap_bytes32;
+    };
+
+    inline const implementation& scalar_implementation()
+    {
+        static const implementation impl = {"scalar", 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+        return impl;
+    }
+
+} // namespace utf8::internal::simd
+} // namespace utf8::internal
+} // namespace utf8
+
+#endif // header guard
@@ -0,0 +1,538 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_SIMD_SSE_H_f6695056_3748_4bf6_b39f_210436e8c8f7
+#define UTF8_FOR_CPP_SIMD_SSE_H_f6695056_3748_4bf6_b39f_210436e8c8f7
+
+#include "x86.h"
+
+#ifdef UTF_CPP_SIMD_X86
+
+namespace utf8
+{
+namespace internal
+{
+namespace simd
+{
+// 16 bytes per step; needs SSSE3 for pshufb and SSE4.1 for ptest, both
+// implied by SSE4.2
+namespace sse
+{
+    inline UTF_CPP_TARGET_SSE42 __m128i load_table(const unsigned char* table)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+    }
+
+    inline UTF_CPP_TARGET_SSE42 __m128i high_nibbles(__m128i v)
+    {
+        return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0f));
+    }
+
+    inline UTF_CPP_TARGET_SSE42 __m128i check_special_cases(__m128i input, __m128i prev1)
+    {
+        const __m128i byte_1_high = _mm_shuffle_epi8(load_table(byte_1_high_table), high_nibbles(prev1));
+        const __m128i byte_1_low  = _mm_shuffle_epi8(load_table(byte_1_low_table),
+                                                     _mm_and_si128(prev1, _mm_set1_epi8(0x0f)));
+        const __m128i byte_2_high = _mm_shuffle_epi8(load_table(byte_2_high_table), high_nibbles(input));
+        return _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+    }
+
+    inline UTF_CPP_TARGET_SSE42 __m128i check_multibyte_lengths(__m128i input, __m128i prev_input, __m128i special_cases)
+    {
+        // The third and fourth bytes of 3 and 4 byte sequences must be trail
+        // octets; the tables only look at adjacent pairs
+        const __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+        const __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+        const __m128i is_third_byte  = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xe0u - 0x80u)));
+        const __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xf0u - 0x80u)));
+        const __m128i must_be_trail = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte),
+                                                    _mm_set1_epi8(static_cast<char>(0x80)));
+        return _mm_xor_si128(must_be_trail, special_cases);
+    }
+
+    // Returns how far from start the input is known to be valid UTF-8; see resync()
+    inline UTF_CPP_TARGET_SSE42 const char* validate(const char* start, const char* end)
+    {
+        const __m128i limits = load_table(incomplete_limits);
+        __m128i prev_input = _mm_setzero_si128();
+        __m128i prev_incomplete = _mm_setzero_si128();
+        const char* it = start;
+        while (end - it >= 16) {
+            const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            __m128i error;
+            if (_mm_movemask_epi8(input) == 0) {
+                // ASCII block: only a sequence left open by the previous block can fail
+                error = prev_incomplete;
+                prev_incomplete = _mm_setzero_si128();
+            } else {
+                const __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+                error = check_multibyte_lengths(input, prev_input, check_special_cases(input, prev1));
+                prev_incomplete = _mm_subs_epu8(input, limits);
+            }
+            if (!_mm_testz_si128(error, error))
+                break;
+            prev_input = input;
+            it += 16;
+        }
+        return resync(start, it);
+    }
+
+    // Stores the four 16 bit lanes of the low half of units selected by keep
+    inline UTF_CPP_TARGET_SSE42 void store_packed_utf16(__m128i units, unsigned int keep, uint16_t*& out)
+    {
+        const __m128i shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pack_utf16_table[keep]));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(units, shuffle));
+        out += _mm_popcnt_u32(keep);
+    }
+
+    // The code units of a block: at the last octet of each one, two or three
+    // octet sequence, its code point. The other positions hold leftovers.
+    inline UTF_CPP_TARGET_SSE42 __m128i utf16_units(__m128i w0, __m128i w1, __m128i w2, __m128i two_end, __m128i three_end)
+    {
+        const __m128i low6 = _mm_set1_epi16(0x3f);
+        // The lead of a two octet sequence has bit 5 clear
+        const __m128i t2 = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(w1, low6), 6), _mm_and_si128(w0, low6));
+        // The 16 bit shift drops the 1110 prefix of a three octet lead
+        const __m128i t3 = _mm_or_si128(_mm_slli_epi16(w2, 12), t2);
+        return _mm_blendv_epi8(_mm_blendv_epi8(w0, t2, two_end), t3, three_end);
+    }
+
+    // Stores the four 16 bit lanes of the low half of units selected by keep,
+    // widened to 32 bits
+    inline UTF_CPP_TARGET_SSE42 void store_packed_utf16(__m128i units, unsigned int keep, uint32_t*& out)
+    {
+        const __m128i shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pack_utf16_table[keep]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu16_epi32(_mm_shuffle_epi8(units, shuffle)));
+        out += _mm_popcnt_u32(keep);
+    }
+
+    // Stores 16 ASCII octets as code units
+    inline UTF_CPP_TARGET_SSE42 void store_ascii(__m128i input, uint16_t* out)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(input, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(input, zero));
+    }
+
+    inline UTF_CPP_TARGET_SSE42 void store_ascii(__m128i input, uint32_t* out)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvtepu8_epi32(input));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_cvtepu8_epi32(_mm_srli_si128(input, 4)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_cvtepu8_epi32(_mm_srli_si128(input, 8)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_cvtepu8_epi32(_mm_srli_si128(input, 12)));
+    }
+
+    // As above, narrowed to Latin-1; the units are all below 0x100
+    inline UTF_CPP_TARGET_SSE42 void store_packed_utf16(__m128i units, unsigned int keep, char*& out)
+    {
+        const __m128i shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pack_utf16_table[keep]));
+        const int octets = _mm_cvtsi128_si32(_mm_packus_epi16(_mm_shuffle_epi8(units, shuffle), _mm_setzero_si128()));
+        std::memcpy(out, &octets, 4);
+        out += _mm_popcnt_u32(keep);
+    }
+
+    inline UTF_CPP_TARGET_SSE42 void store_ascii(__m128i input, char* out)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), input);
+    }
+
+    // The octets that start a code point too large for the code units: the
+    // leads above 0xc3 for Latin-1, none otherwise
+    inline UTF_CPP_TARGET_SSE42 unsigned int wide_leads(__m128i, const uint16_t*)
+    {
+        return 0;
+    }
+
+    inline UTF_CPP_TARGET_SSE42 unsigned int wide_leads(__m128i, const uint32_t*)
+    {
+        return 0;
+    }
+
+    inline UTF_CPP_TARGET_SSE42 unsigned int wide_leads(__m128i input, const char*)
+    {
+        const __m128i wide = _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(static_cast<char>(0xc4))), input);
+        return static_cast<unsigned int>(_mm_movemask_epi8(wide));
+    }
+
+    // UTF-8 -> UTF-16, UTF-32 or Latin-1. Converts 16 byte blocks starting at in, as
+    // long as they are valid and out has room for 16 code units; stops on a
+    // sequence boundary, leaving the rest to the scalar code. Four octet
+    // sequences are left to the scalar code as well, and so are the code
+    // points that do not fit in the units.
+    template <typename unit_type>
+    inline UTF_CPP_TARGET_SSE42 void utf8_to_units(const char*& in, const char* end,
+                                                  unit_type*& out, unit_type* out_end)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i limits = load_table(incomplete_limits);
+        const char* it = in;
+        unit_type* result = out;
+        while (end - it >= 16 && out_end - result >= 16) {
+            const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            if (_mm_movemask_epi8(input) == 0) {
+                store_ascii(input, result);
+                it += 16;
+                result += 16;
+                continue;
+            }
+            // it is on a sequence boundary, so the block is validated on its own
+            const __m128i input_1 = _mm_alignr_epi8(input, zero, 15);
+            const __m128i input_2 = _mm_alignr_epi8(input, zero, 14);
+            const __m128i error = check_multibyte_lengths(input, zero, check_special_cases(input, input_1));
+            if (!_mm_testz_si128(error, error))
+                break;
+            // Stop before a four octet sequence, or one running past the block
+            const __m128i lead4 = _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(static_cast<char>(0xf0))), input);
+            const __m128i complete = _mm_cmpeq_epi8(_mm_subs_epu8(input, limits), zero);
+            const unsigned int stop = static_cast<unsigned int>(_mm_movemask_epi8(_mm_andnot_si128(complete, _mm_set1_epi8(-1)))
+                                                                | _mm_movemask_epi8(lead4)) | wide_leads(input, result);
+            const unsigned int length = stop ? lowest_bit(stop) : 16u;
+            if (length == 0)
+                break;
+
+            const __m128i trail = _mm_cmplt_epi8(input, _mm_set1_epi8(static_cast<char>(0xc0)));
+            const __m128i after_trail = _mm_alignr_epi8(trail, zero, 15);
+            const __m128i two_end = _mm_andnot_si128(after_trail, trail);
+            const __m128i three_end = _mm_and_si128(after_trail, trail);
+            const unsigned int in_block = (1u << length) - 1;
+            const unsigned int emit = ~(static_cast<unsigned int>(_mm_movemask_epi8(trail)) >> 1) & in_block;
+
+            const __m128i low = utf16_units(_mm_unpacklo_epi8(input, zero), _mm_unpacklo_epi8(input_1, zero),
+                                            _mm_unpacklo_epi8(input_2, zero), _mm_unpacklo_epi8(two_end, two_end),
+                                            _mm_unpacklo_epi8(three_end, three_end));
+            const __m128i high = utf16_units(_mm_unpackhi_epi8(input, zero), _mm_unpackhi_epi8(input_1, zero),
+                                             _mm_unpackhi_epi8(input_2, zero), _mm_unpackhi_epi8(two_end, two_end),
+                                             _mm_unpackhi_epi8(three_end, three_end));
+            store_packed_utf16(low, emit & 0xf, result);
+            store_packed_utf16(_mm_unpackhi_epi64(low, low), (emit >> 4) & 0xf, result);
+            store_packed_utf16(high, (emit >> 8) & 0xf, result);
+            store_packed_utf16(_mm_unpackhi_epi64(high, high), (emit >> 12) & 0xf, result);
+            it += length;
+        }
+        in = it;
+        out = result;
+    }
+
+    inline UTF_CPP_TARGET_SSE42 void utf8_to_utf16(const char*& in, const char* end,
+                                                  uint16_t*& out, uint16_t* out_end)
+    {
+        utf8_to_units(in, end, out, out_end);
+    }
+
+    inline UTF_CPP_TARGET_SSE42 void utf8_to_utf32(const char*& in, const char* end,
+                                                  uint32_t*& out, uint32_t* out_end)
+    {
+        utf8_to_units(in, end, out, out_end);
+    }
+
+    inline UTF_CPP_TARGET_SSE42 void utf8_to_latin1(const char*& in, const char* end,
+                                                   char*& out, char* out_end)
+    {
+        utf8_to_units(in, end, out, out_end);
+    }
+
+    // Latin-1 -> UTF-8. Converts 16 byte blocks, as long as out has room for
+    // 32 octets; every octet is a code point below 0x100.
+    inline UTF_CPP_TARGET_SSE42 void latin1_to_utf8(const char*& in, const char* end,
+                                                   char*& out, char* out_end)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const char* it = in;
+        char* result = out;
+        while (end - it >= 16 && out_end - result >= 32) {
+            const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            if (_mm_movemask_epi8(input) == 0) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result), input);
+                result += 16;
+            } else {
+                store_utf8_below_800(_mm_unpacklo_epi8(input, zero), result);
+                store_utf8_below_800(_mm_unpackhi_epi8(input, zero), result);
+            }
+            it += 16;
+        }
+        in = it;
+        out = result;
+    }
+
+    // Byte order. Reverses the bytes of each code unit in 16 byte blocks.
+    template <typename unit_type>
+    inline UTF_CPP_TARGET_SSE42 void swap_bytes(unit_type*& units, const unit_type* end, __m128i shuffle)
+    {
+        const std::ptrdiff_t block = 16 / sizeof(unit_type);
+        unit_type* it = units;
+        for (; end - it >= block; it += block) {
+            __m128i* const p = reinterpret_cast<__m128i*>(it);
+            _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), shuffle));
+        }
+        units = it;
+    }
+
+    inline UTF_CPP_TARGET_SSE42 void swap_bytes16(uint16_t*& units, const uint16_t* end)
+    {
+        swap_bytes(units, end, _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14));
+    }
+
+    inline UTF_CPP_TARGET_SSE42 void swap_bytes32(uint32_t*& units, const uint32_t* end)
+    {
+        swap_bytes(units, end, _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+    }
+
+    // Encodes the code point in each 32 bit lane as UTF-8, in memory order
+    inline UTF_CPP_TARGET_SSE42 __m128i utf8_octets(__m128i cp, __m128i two_or_more, __m128i three_or_more, __m128i four)
+    {
+        const __m128i low6 = _mm_set1_epi32(0x3f);
+        const __m128i cont = _mm_set1_epi32(0x80);
+        const __m128i c0 = _mm_or_si128(cont, _mm_and_si128(cp, low6));
+        const __m128i c1 = _mm_or_si128(cont, _mm_and_si128(_mm_srli_epi32(cp, 6), low6));
+        const __m128i c2 = _mm_or_si128(cont, _mm_and_si128(_mm_srli_epi32(cp, 12), low6));
+        const __m128i enc2 = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(0xc0), _mm_srli_epi32(cp, 6)), _mm_slli_epi32(c0, 8));
+        const __m128i enc3 = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(0xe0), _mm_srli_epi32(cp, 12)),
+                                          _mm_or_si128(_mm_slli_epi32(c1, 8), _mm_slli_epi32(c0, 16)));
+        const __m128i enc4 = _mm_or_si128(_mm_or_si128(_mm_set1_epi32(0xf0), _mm_srli_epi32(cp, 18)),
+                                          _mm_or_si128(_mm_slli_epi32(c2, 8), _mm_or_si128(_mm_slli_epi32(c1, 16), _mm_slli_epi32(c0, 24))));
+        return _mm_blendv_epi8(_mm_blendv_epi8(_mm_blendv_epi8(cp, enc2, two_or_more), enc3, three_or_more), enc4, four);
+    }
+
+    // The pshufb control that packs the first length octets of each 32 bit
+    // lane together, given the inclusive prefix sums of the lengths (ends)
+    inline UTF_CPP_TARGET_SSE42 __m128i utf8_pack_shuffle(__m128i ends)
+    {
+        const __m128i position = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        const __m128i end0 = _mm_shuffle_epi8(ends, _mm_setzero_si128());
+        const __m128i end1 = _mm_shuffle_epi8(ends, _mm_set1_epi8(4));
+        const __m128i end2 = _mm_shuffle_epi8(ends, _mm_set1_epi8(8));
+        const __m128i past0 = _mm_cmpeq_epi8(_mm_max_epu8(position, end0), position);
+        const __m128i past1 = _mm_cmpeq_epi8(_mm_max_epu8(position, end1), position);
+        const __m128i past2 = _mm_cmpeq_epi8(_mm_max_epu8(position, end2), position);
+        // The lane each output octet comes from, and where the lane's octets start
+        const __m128i lane = _mm_sub_epi8(_mm_setzero_si128(), _mm_add_epi8(_mm_add_epi8(past0, past1), past2));
+        const __m128i lane_start = _mm_max_epu8(_mm_max_epu8(_mm_and_si128(past0, end0), _mm_and_si128(past1, end1)),
+                                                _mm_and_si128(past2, end2));
+        const __m128i lane_offset = _mm_add_epi8(lane, lane);
+        return _mm_add_epi8(_mm_add_epi8(lane_offset, lane_offset), _mm_sub_epi8(position, lane_start));
+    }
+
+    // UTF-16 -> UTF-8. Converts blocks of 16 ASCII units, 8 units below
+    // 0x800 or 4 arbitrary units, as long as they are valid and out has room
+    // for 16 octets; stops before a lone surrogate. A lead surrogate ending a
+    // block takes its trail surrogate along.
+    inline UTF_CPP_TARGET_SSE42 void utf16_to_utf8(const uint16_t*& in, const uint16_t* end,
+                                                  char*& out, char* out_end)
+    {
+        const uint16_t* it = in;
+        char* result = out;
+        while (end - it >= 16 && out_end - result >= 16) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 8));
+            if (_mm_testz_si128(_mm_or_si128(first, second), _mm_set1_epi16(static_cast<short>(0xff80)))) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(result), _mm_packus_epi16(first, second));
+                it += 16;
+                result += 16;
+                continue;
+            }
+            if (_mm_testz_si128(first, _mm_set1_epi16(static_cast<short>(0xf800)))) {
+                store_utf8_below_800(first, result);
+                it += 8;
+                continue;
+            }
+            const __m128i u = _mm_cvtepu16_epi32(first);
+            const __m128i next = _mm_cvtepu16_epi32(_mm_srli_si128(first, 2));
+            const __m128i surrogate_mask = _mm_set1_epi32(0xfc00);
+            const __m128i lead = _mm_cmpeq_epi32(_mm_and_si128(u, surrogate_mask), _mm_set1_epi32(0xd800));
+            const __m128i trail = _mm_cmpeq_epi32(_mm_and_si128(u, surrogate_mask), _mm_set1_epi32(0xdc00));
+            const unsigned int lead_bits = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(lead)));
+            const unsigned int trail_bits = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(trail)));
+            __m128i cp = u;
+            if (lead_bits | trail_bits) {
+                // Each lead surrogate must be followed by a trail surrogate, and vice versa
+                const __m128i next_trail = _mm_cmpeq_epi32(_mm_and_si128(next, surrogate_mask), _mm_set1_epi32(0xdc00));
+                const unsigned int next_trail_bits = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(next_trail)));
+                if ((lead_bits & ~next_trail_bits) != 0 || trail_bits != ((lead_bits << 1) & 0xf))
+                    break;
+                const __m128i pair = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(u, 10), next),
+                                                   _mm_set1_epi32(static_cast<int>(0xfca02400u)));
+                cp = _mm_blendv_epi8(cp, pair, lead);
+            }
+            const __m128i two_or_more = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7f));
+            const __m128i three_or_more = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7ff));
+            const __m128i four = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0xffff));
+            // Octets per lane; trail surrogates are encoded with their leads
+            const __m128i length = _mm_andnot_si128(trail, _mm_sub_epi32(_mm_sub_epi32(_mm_sub_epi32(
+                _mm_set1_epi32(1), two_or_more), three_or_more), four));
+            __m128i ends = _mm_add_epi32(length, _mm_slli_si128(length, 4));
+            ends = _mm_add_epi32(ends, _mm_slli_si128(ends, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result),
+                             _mm_shuffle_epi8(utf8_octets(cp, two_or_more, three_or_more, four), utf8_pack_shuffle(ends)));
+            result += _mm_extract_epi32(ends, 3);
+            it += 4 + (lead_bits >> 3);
+        }
+        in = it;
+        out = result;
+    }
+
+    // UTF-32 -> UTF-8. Converts blocks of 16 ASCII code points, 8 below
+    // 0x800 or 4 arbitrary ones, as long as they are valid and out has room
+    // for 16 octets; stops before a surrogate or a value above 0x10ffff.
+    inline UTF_CPP_TARGET_SSE42 void utf32_to_utf8(const uint32_t*& in, const uint32_t* end,
+                                                  char*& out, char* out_end)
+    {
+        const uint32_t* it = in;
+        char* result = out;
+        while (end - it >= 16 && out_end - result >= 16) {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 4));
+            const __m128i ab = _mm_or_si128(a, b);
+            if (_mm_testz_si128(ab, _mm_set1_epi32(~0x7f))) {
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 8));
+                const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 12));
+                if (_mm_testz_si128(_mm_or_si128(c, d), _mm_set1_epi32(~0x7f))) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(result),
+                                     _mm_packus_epi16(_mm_packus_epi32(a, b), _mm_packus_epi32(c, d)));
+                    it += 16;
+                    result += 16;
+                    continue;
+                }
+            }
+            if (_mm_testz_si128(ab, _mm_set1_epi32(~0x7ff))) {
+                store_utf8_below_800(_mm_packus_epi32(a, b), result);
+                it += 8;
+                continue;
+            }
+            const __m128i cp = a;
+            const __m128i surrogate = _mm_cmpeq_epi32(_mm_and_si128(cp, _mm_set1_epi32(static_cast<int>(0xfffff800u))),
+                                                      _mm_set1_epi32(0xd800));
+            const __m128i in_range = _mm_cmpeq_epi32(_mm_min_epu32(cp, _mm_set1_epi32(0x10ffff)), cp);
+            if (_mm_movemask_epi8(_mm_andnot_si128(surrogate, in_range)) != 0xffff)
+                break;
+            const __m128i two_or_more = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7f));
+            const __m128i three_or_more = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0x7ff));
+            const __m128i four = _mm_cmpgt_epi32(cp, _mm_set1_epi32(0xffff));
+            const __m128i length = _mm_sub_epi32(_mm_sub_epi32(_mm_sub_epi32(
+                _mm_set1_epi32(1), two_or_more), three_or_more), four);
+            __m128i ends = _mm_add_epi32(length, _mm_slli_si128(length, 4));
+            ends = _mm_add_epi32(ends, _mm_slli_si128(ends, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(result),
+                             _mm_shuffle_epi8(utf8_octets(cp, two_or_more, three_or_more, four), utf8_pack_shuffle(ends)));
+            result += _mm_extract_epi32(ends, 3);
+            it += 4;
+        }
+        in = it;
+        out = result;
+    }
+
+    // Output lengths, 16 bytes at a time. Every octet but the trail ones
+    // (0x80 to 0xbf, below -64 as signed) starts a code point; a four octet
+    // sequence takes a surrogate pair in UTF-16.
+    inline UTF_CPP_TARGET_SSE42 std::size_t utf32_length_from_utf8(const char*& in, const char* end)
+    {
+        const char* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 16; it += 16) {
+            const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const __m128i starts = _mm_cmpgt_epi8(input, _mm_set1_epi8(-65));
+            length += static_cast<std::size_t>(_mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_epi8(starts))));
+        }
+        in = it;
+        return length;
+    }
+
+    inline UTF_CPP_TARGET_SSE42 std::size_t utf16_length_from_utf8(const char*& in, const char* end)
+    {
+        const char* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 16; it += 16) {
+            const __m128i input = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const __m128i starts = _mm_cmpgt_epi8(input, _mm_set1_epi8(-65));
+            const __m128i lead4 = _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(static_cast<char>(0xf0))), input);
+            length += static_cast<std::size_t>(_mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_epi8(starts)))
+                                               + _mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_epi8(lead4))));
+        }
+        in = it;
+        return length;
+    }
+
+    // Three octets per unit, less one below 0x80, one more below 0x800 and
+    // one for each surrogate, which makes four per pair. The 16 bit lanes
+    // count twice in the byte masks.
+    inline UTF_CPP_TARGET_SSE42 std::size_t utf8_length_from_utf16(const uint16_t*& in, const uint16_t* end)
+    {
+        const uint16_t* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 8; it += 8) {
+            const __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const __m128i one = _mm_cmpeq_epi16(_mm_min_epu16(units, _mm_set1_epi16(0x7f)), units);
+            const __m128i two = _mm_cmpeq_epi16(_mm_min_epu16(units, _mm_set1_epi16(0x7ff)), units);
+            const __m128i surrogate = _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16(static_cast<short>(0xf800))),
+                                                      _mm_set1_epi16(static_cast<short>(0xd800)));
+            const unsigned int shorter = static_cast<unsigned int>(_mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_epi8(one)))
+                                                                   + _mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_epi8(two)))
+                                                                   + _mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_epi8(surrogate))));
+            length += 24 - shorter / 2;
+        }
+        in = it;
+        return length;
+    }
+
+    // Four octets per code point, less one for each of the limits below it
+    inline UTF_CPP_TARGET_SSE42 std::size_t utf8_length_from_utf32(const uint32_t*& in, const uint32_t* end)
+    {
+        const uint32_t* it = in;
+        std::size_t length = 0;
+        for (; end - it >= 4; it += 4) {
+            const __m128i cp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+            const __m128i one = _mm_cmpeq_epi32(_mm_min_epu32(cp, _mm_set1_epi32(0x7f)), cp);
+            const __m128i two = _mm_cmpeq_epi32(_mm_min_epu32(cp, _mm_set1_epi32(0x7ff)), cp);
+            const __m128i three = _mm_cmpeq_epi32(_mm_min_epu32(cp, _mm_set1_epi32(0xffff)), cp);
+            const unsigned int shorter = static_cast<unsigned int>(_mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(one))))
+                                                                   + _mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(two))))
+                                                                   + _mm_popcnt_u32(static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(three)))));
+            length += 16 - shorter;
+        }
+        in = it;
+        return length;
+    }
+
+} // namespace utf8::internal::simd::sse
+
+    UTF_CPP_SIMD_INLINE const implementation& sse42_implementation()
+    {
+        static const implementation impl = {"sse4.2", sse::validate, sse::utf8_to_utf16, sse::utf16_to_utf8,
+                                            sse::utf8_to_utf32, sse::utf32_to_utf8,
+                                            sse::utf16_length_from_utf8, sse::utf32_length_from_utf8,
+                                            sse::utf8_length_from_utf16, sse::utf8_length_from_utf32,
+                                            sse::latin1_to_utf8, sse::utf8_to_latin1,
+                                            sse::swap_bytes16, sse::swap_bytes32};
+        return impl;
+    }
+
+} // namespace utf8::internal::simd
+} // namespace utf8::internal
+} // namespace utf8
+
+#endif // UTF_CPP_SIMD_X86
+
+#endif // header guard
@@ -0,0 +1,218 @@
+// Copyright 2026 Nemanja Trifunovic
+
+/*
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef UTF8_FOR_CPP_SIMD_X86_H_61822264_e8ed_45a0_8f57_9af91e98b123
+#define UTF8_FOR_CPP_SIMD_X86_H_61822264_e8ed_45a0_8f57_9af91e98b123
+
+#include "implementation.h"
+
+// Vectorized kernels are provided for x86-64 only. Define UTF_CPP_DISABLE_SIMD
+// to build the library without them.
+#if !defined(UTF_CPP_DISABLE_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+    #define UTF_CPP_SIMD_X86
+#endif
+
+#ifdef UTF_CPP_SIMD_X86
+
+#include <immintrin.h>
+
+// The kernels are compiled for their instruction set regardless of the -m/arch
+// flags the including translation unit was built with.
+#if defined(_MSC_VER) && !defined(__clang__)
+    #define UTF_CPP_TARGET_SSE42
+    #define UTF_CPP_TARGET_AVX2
+#else
+    #define UTF_CPP_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+    #define UTF_CPP_TARGET_AVX2  __attribute__((target("avx2,bmi,bmi2,popcnt")))
+#endif
+
+namespace utf8
+{
+namespace internal
+{
+namespace simd
+{
+    // Error classes of the lookup-table validator. Every invalid pair of
+    // adjacent bytes sets the same bit in all three tables below; see
+    // Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"
+    enum {
+        TOO_SHORT      = 1 << 0, // 11______ 0_______  or  11______ 11______
+        TOO_LONG       = 1 << 1, // 0_______ 10______
+        OVERLONG_3     = 1 << 2, // 11100000 100_____
+        TOO_LARGE      = 1 << 3, // 11110100 1001____ and above
+        SURROGATE      = 1 << 4, // 11101101 101_____
+        OVERLONG_2     = 1 << 5, // 1100000_ 10______
+        TOO_LARGE_1000 = 1 << 6, // 11110101 1000____ and above
+        OVERLONG_4     = 1 << 6, // 11110000 1000____
+        TWO_CONTS      = 1 << 7, // 10______ 10______
+        CARRY          = TOO_SHORT | TOO_LONG | TWO_CONTS
+    };
+
+    // Indexed by the high nibble of the first byte of a pair
+    static const unsigned char byte_1_high_table[16] = {
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+        TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+        TOO_SHORT | OVERLONG_2,
+        TOO_SHORT,
+        TOO_SHORT | OVERLONG_3 | SURROGATE,
+        TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4
+    };
+
+    // Indexed by the low nibble of the first byte of a pair
+    static const unsigned char byte_1_low_table[16] = {
+        CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+        CARRY | OVERLONG_2,
+        CARRY,
+        CARRY,
+        CARRY | TOO_LARGE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+        CARRY | TOO_LARGE | TOO_LARGE_1000,
+        CARRY | TOO_LARGE | TOO_LARGE_1000
+    };
+
+    // Indexed by the high nibble of the second byte of a pair
+    static const unsigned char byte_2_high_table[16] = {
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE,
+        TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE  | TOO_LARGE,
+        TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT
+    };
+
+    // A block is complete unless one of its last three bytes starts a sequence
+    // that runs past the block end. Bytes above these limits are such leads.
+    static const unsigned char incomplete_limits[16] = {
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf
+    };
+
+    // pshufb controls that pack the 16 bit lanes selected by a 4 bit mask
+    // into the low lanes of a 64 bit half
+    static const unsigned char pack_utf16_table[16][8] = {
+        {0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+        {0x02, 0x03, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x80, 0x80, 0x80, 0x80},
+        {0x04, 0x05, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80},
+        {0x02, 0x03, 0x04, 0x05, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x80, 0x80},
+        {0x06, 0x07, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80},
+        {0x02, 0x03, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x06, 0x07, 0x80, 0x80},
+        {0x04, 0x05, 0x06, 0x07, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80},
+        {0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07}
+    };
+
+    // pshufb controls that pack four 16 bit lanes of one or two octets into
+    // UTF-8; bit i of the index is set if lane i takes two octets
+    static const unsigned char pack_utf8_2_table[16][8] = {
+        {0x00, 0x02, 0x04, 0x06, 0x80, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x04, 0x06, 0x80, 0x80, 0x80},
+        {0x00, 0x02, 0x03, 0x04, 0x06, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x06, 0x80, 0x80},
+        {0x00, 0x02, 0x04, 0x05, 0x06, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x04, 0x05, 0x06, 0x80, 0x80},
+        {0x00, 0x02, 0x03, 0x04, 0x05, 0x06, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x80},
+        {0x00, 0x02, 0x04, 0x06, 0x07, 0x80, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x04, 0x06, 0x07, 0x80, 0x80},
+        {0x00, 0x02, 0x03, 0x04, 0x06, 0x07, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x06, 0x07, 0x80},
+        {0x00, 0x02, 0x04, 0x05, 0x06, 0x07, 0x80, 0x80},
+        {0x00, 0x01, 0x02, 0x04, 0x05, 0x06, 0x07, 0x80},
+        {0x00, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x80},
+        {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07}
+    };
+
+    // The index of the lowest set bit; bits must not be zero
+    inline unsigned int lowest_bit(unsigned int bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, bits);
+        return static_cast<unsigned int>(index);
+#else
+        return static_cast<unsigned int>(__builtin_ctz(bits));
+#endif
+    }
+
+    // Encodes eight code units below 0x800, in 16 bit lanes, as UTF-8
+    inline UTF_CPP_TARGET_SSE42 void store_utf8_below_800(__m128i units, char*& out)
+    {
+        const __m128i two = _mm_cmpgt_epi16(units, _mm_set1_epi16(0x7f));
+        const __m128i lead = _mm_or_si128(_mm_srli_epi16(units, 6), _mm_set1_epi16(0xc0));
+        const __m128i trail = _mm_or_si128(_mm_and_si128(units, _mm_set1_epi16(0x3f)), _mm_set1_epi16(0x80));
+        const __m128i octets = _mm_blendv_epi8(units, _mm_or_si128(lead, _mm_slli_epi16(trail, 8)), two);
+        const unsigned int two_bits = static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(two, two))) & 0xff;
+        const __m128i low_shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pack_utf8_2_table[two_bits & 0xf]));
+        const __m128i high_shuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pack_utf8_2_table[two_bits >> 4]));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(octets, low_shuffle));
+        out += 4 + _mm_popcnt_u32(two_bits & 0xf);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(_mm_unpackhi_epi64(octets, octets), high_shuffle));
+        out += 4 + _mm_popcnt_u32(two_bits >> 4);
+    }
+
+    // The vectorized kernels validate whole blocks. Everything in [start, it)
+    // is known to be valid, except possibly for a sequence that starts within
+    // the last three bytes and continues past it. Step back to the lead octet
+    // of such a sequence so that scalar code can resume on a sequence boundary.
+    inline const char* resync(const char* start, const char* it)
+    {
+        for (int i = 1; i <= 3 && it - i >= start; ++i) {
+            const unsigned char octet = static_cast<unsigned char>(*(it - i));
+            if (octet < 0x80)
+                return it;
+            if (octet >= 0xc0) {
+                const int length = (octet >= 0xf0) ? 4 : (octet >= 0xe0) ? 3 : 2;
+                return (length > i) ? it - i : it;
+            }
+        }
+        return it;
+    }
+
+} // namespace utf8::internal::simd
+} // namespace utf8::internal
+} // namespace utf8
+
+#endif // UTF_CPP_SIMD_X86
+
+#endif // header guard
@@ -157,13 +157,15 @@ namespace utf8
         void advance(octet_iterator& it, distance_type n)
         {
             const distance_type zero(0);
+            // Contiguous input: the code points are counted in bulk, and
+            // only the last few are stepped over one at a time
             if (n < zero) {
                 // backward
-                for (distance_type i = n; i < zero; ++i)
+                for (distance_type i = n + static_cast<distance_type>(utf8::internal::skip_code_points_back(it, -static_cast<std::ptrdiff_t>(n))); i < zero; ++i)
                     utf8::unchecked::prior(it);
             } else {
                 // forward
-                for (distance_type i = zero; i < n; ++i)
+                for (distance_type i = static_cast<distance_type>(utf8::internal::skip_code_points(it, static_cast<std::ptrdiff_t>(n))); i < n; ++i)
                     utf8::unchecked::next(it);
             }
         }
@@ -172,16 +174,17 @@ namespace utf8
         typename std::iterator_traits<octet_iterator>::difference_type
         distance(octet_iterator first, octet_iterator last)
         {
-            typename std::iterator_traits<octet_iterator>::difference_type dist;
-            for (dist = 0; first < last; ++dist)
-                utf8::unchecked::next(first);
-            return dist;
+            // No need to decode: every octet but the trail ones starts a code point
+            return utf8::internal::count_code_points(first, last);
         }
 
         template <typename u16bit_iterator, typename octet_iterator>
         octet_iterator utf16to8(u16bit_iterator start, u16bit_iterator end, octet_iterator result)
         {
             while (start != end) {
+                start = utf8::internal::utf16to8_blocks(start, end, result);
+                if (start == end)
+                    break;
                 utfchar32_t cp = utf8::internal::mask16(*start++);
                 // Take care of surrogate pairs first
                 if (utf8::internal::is_lead_surrogate(cp)) {
@@ -199,6 +202,9 @@ namespace utf8
         u16bit_iterator utf8to16(octet_iterator start, octet_iterator end, u16bit_iterator result)
         {
             while (start < end) {
+                start = utf8::internal::utf8to16_blocks(start, end, result);
+                if (start == end)
+                    break;
                 utfchar32_t cp = utf8::unchecked::next(start);
                 if (cp > 0xffff) { //make a surrogate pair
                     *result++ = static_cast<utfchar16_t>((cp >> 10)   + internal::LEAD_OFFSET);
@@ -213,8 +219,12 @@ namespace utf8
         template <typename octet_iterator, typename u32bit_iterator>
         octet_iterator utf32to8(u32bit_iterator start, u32bit_iterator end, octet_iterator result)
         {
-            while (start != end)
+            while (start != end) {
+                start = utf8::internal::utf32to8_blocks(start, end, result);
+                if (start == end)
+                    break;
                 result = utf8::unchecked::append(*(start++), result);
+            }
 
             return result;
         }
@@ -222,8 +232,12 @@ namespace utf8
         template <typename octet_iterator, typename u32bit_iterator>
         u32bit_iterator utf8to32(octet_iterator start, octet_iterator end, u32bit_iterator result)
         {
-            while (start < end)
+            while (start < end) {
+                start = utf8::internal::utf8to32_blocks(start, end, result);
+                if (start == end)
+                    break;
                 (*result++) = utf8::unchecked::next(start);
+            }
 
             return result;
         }
@@ -6,3 +6,4 @@
 #include "test_checked_iterator.h"
 #include "test_unchecked_api.h"
 #include "test_unchecked_iterator.h"
+#include "test_nothrow_api.h"
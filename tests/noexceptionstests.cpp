@@ -2,3 +2,4 @@
 
 #include "test_unchecked_api.h"
 #include "test_unchecked_iterator.h"
+#include "test_nothrow_api.h"
@@ -5,9 +5,26 @@
 
 #include <string>
 #include <vector>
+#include <list>
 using namespace utf8;
 using namespace std;
 
+// Mixed 1 to 4 octet text spanning several vector blocks
+static string mixed_text()
+{
+    string text;
+    for (size_t i = 0; i < 50; ++i)
+        text += string(i % 7, 'a') + "\xd1\x88" + "\xe6\x97\xa5" + string(i % 3, 'b') + "\xf0\x9d\x84\x9e";
+    return text;
+}
+
+// mixed_text() in UTF-16 and UTF-32, converted through the scalar code
+static void mixed_text_transcodings(vector<utfchar16_t>& utf16, vector<utfchar32_t>& utf32)
+{
+    const string text = mixed_text();
+    utf8to16(text.begin(), text.end(), back_inserter(utf16));
+    utf8to32(text.begin(), text.end(), back_inserter(utf32));
+}
 
 TEST(CheckedAPITests, test_append)
 {
@@ -107,6 +124,37 @@ TEST(CheckedAPITests, test_next_error_precedence)
     it = invalid_trailing_byte_after_invalid_range;
     EXPECT_THROW(next(it, invalid_trailing_byte_after_invalid_range + 4), invalid_utf8);
     EXPECT_EQ(it, invalid_trailing_byte_after_invalid_range);
+
+    // Value errors are only reported for complete sequences
+    const char truncated_two_octet_overlong[] = {static_cast<char>(0xc0)};
+    it = truncated_two_octet_overlong;
+    EXPECT_THROW(next(it, truncated_two_octet_overlong + 1), not_enough_room);
+    EXPECT_EQ(it, truncated_two_octet_overlong);
+
+    const char two_octet_overlong[] = {static_cast<char>(0xc1), static_cast<char>(0xbf)};
+    it = two_octet_overlong;
+    EXPECT_THROW(next(it, two_octet_overlong + 2), invalid_utf8);
+    EXPECT_EQ(it, two_octet_overlong);
+
+    const char surrogate[] = {static_cast<char>(0xed), static_cast<char>(0xa0), static_cast<char>(0x80)};
+    it = surrogate;
+    EXPECT_THROW(next(it, surrogate + 3), invalid_code_point);
+    EXPECT_EQ(it, surrogate);
+
+    const char above_max[] = {
+        static_cast<char>(0xf5), static_cast<char>(0x80), static_cast<char>(0x80), static_cast<char>(0x80)
+    };
+    it = above_max;
+    EXPECT_THROW(next(it, above_max + 4), invalid_code_point);
+    EXPECT_EQ(it, above_max);
+    EXPECT_THROW(next(it, above_max + 3), not_enough_room);
+
+    const char five_octet_lead[] = {
+        static_cast<char>(0xf8), static_cast<char>(0x80), static_cast<char>(0x80), static_cast<char>(0x80)
+    };
+    it = five_octet_lead;
+    EXPECT_THROW(next(it, five_octet_lead + 4), invalid_utf8);
+    EXPECT_EQ(it, five_octet_lead);
 }
 
 TEST(CheckedAPITests, test_next16)
@@ -183,6 +231,38 @@ TEST(CheckedAPITests, test_advance)
     EXPECT_EQ(w, threechars + 4);
     advance(w, -1, threechars);
     EXPECT_EQ(w, threechars);
+
+    // Contiguous input is skipped in validated windows, both ways, with
+    // the same results and errors as one code point at a time
+    string text;
+    while (text.size() < 40000)
+        text += "a\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    const char* start = text.data();
+    const char* end = start + text.size();
+    w = start;
+    advance(w, 10001, end);
+    EXPECT_EQ(w, start + 25001);
+    string::iterator it = text.begin();
+    advance(it, 10001, text.end());
+    EXPECT_EQ(it - text.begin(), 25001);
+    advance(w, -10000, start);
+    EXPECT_EQ(w, start + 1);
+    advance(w, 15999, end);
+    EXPECT_EQ(w, end);
+    advance(w, -16000, start);
+    EXPECT_EQ(w, start);
+    EXPECT_THROW(advance(w, 16001, end), not_enough_room);
+    EXPECT_EQ(w, end);
+    EXPECT_THROW(advance(w, -16001, start), not_enough_room);
+    EXPECT_EQ(w, start);
+    string invalid = text;
+    invalid[30001] = '\xff';
+    const char* invalid_start = invalid.data();
+    w = invalid_start;
+    EXPECT_THROW(advance(w, 16000, invalid_start + invalid.size()), invalid_utf8);
+    EXPECT_EQ(w, invalid_start + 30001);
+    w = invalid_start + invalid.size();
+    EXPECT_THROW(advance(w, -16000, invalid_start), invalid_utf8);
 }
 
 TEST(CheckedAPITests, test_distance)
@@ -190,6 +270,254 @@ TEST(CheckedAPITests, test_distance)
     const char* twochars = "\xe6\x97\xa5\xd1\x88";
     size_t dist = static_cast<size_t>(utf8::distance(twochars, twochars + 5));
     EXPECT_EQ (dist, 2);
+
+    // Contiguous input is validated a chunk at a time: sequences cross the
+    // chunk boundaries, and an error far from the start is still found
+    string text;
+    while (text.size() < 40000)
+        text += "a\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    const char* start = text.data();
+    EXPECT_EQ (utf8::distance(start, start + text.size()), utf8::distance(text.begin(), text.end()));
+    EXPECT_EQ (utf8::distance(start + 1, start + text.size() - 4), static_cast<ptrdiff_t>(text.size() / 10 * 4 - 2));
+    string invalid = text;
+    invalid[30001] = '\xff';
+    EXPECT_THROW (utf8::distance(invalid.data(), invalid.data() + invalid.size()), invalid_utf8);
+}
+
+TEST(CheckedAPITests, test_ascii_runs)
+{
+    // Pointer input consumes ASCII runs a word at a time; the results must not
+    // depend on where the runs start and end relative to the words.
+    string text;
+    for (size_t i = 0; i < 40; ++i)
+        text += string(i, 'a') + "\xd1\x88" + string(i % 9, 'b') + "\xf0\x9d\x84\x9e";
+    const char* start = text.c_str();
+    const char* end = start + text.size();
+    EXPECT_EQ (utf8::distance(start, end), utf8::distance(text.begin(), text.end()));
+    u16string from_pointer16, from_iterator16;
+    utf8to16(start, end, back_inserter(from_pointer16));
+    utf8to16(text.begin(), text.end(), back_inserter(from_iterator16));
+    EXPECT_TRUE (from_pointer16 == from_iterator16);
+    u32string from_pointer32, from_iterator32;
+    utf8to32(start, end, back_inserter(from_pointer32));
+    utf8to32(text.begin(), text.end(), back_inserter(from_iterator32));
+    EXPECT_TRUE (from_pointer32 == from_iterator32);
+
+    const string truncated = text.substr(0, 100) + "\xe6\x97";
+    start = truncated.c_str();
+    EXPECT_THROW (utf8::distance(start, start + truncated.size()), not_enough_room);
+    u16string partial;
+    EXPECT_THROW (utf8to16(start, start + truncated.size(), back_inserter(partial)), not_enough_room);
+}
+
+// What utf8to16 throws, if anything: 1 for invalid_code_point, 2 for
+// not_enough_room, and 0x100 plus the octet for invalid_utf8
+template <typename octet_iterator>
+static int utf8to16_outcome(octet_iterator start, octet_iterator end, u16string& out)
+{
+    try {
+        utf8to16(start, end, back_inserter(out));
+    }
+    catch (const invalid_code_point&) {
+        return 1;
+    }
+    catch (const not_enough_room&) {
+        return 2;
+    }
+    catch (const invalid_utf8& e) {
+        return 0x100 + e.utf8_octet();
+    }
+    return 0;
+}
+
+TEST(CheckedAPITests, test_utf8to16_blocks)
+{
+    // The SSE4.2 and AVX2 kernels take 16 and 32 octets at a time. One, two,
+    // three and four octet sequences are mixed within each block, the input
+    // starts at every offset within a block, and an error is planted at
+    // every position of the first 16 and 32 octet blocks; the output and the
+    // exception must be those of the scalar code, which iterators get.
+    string text;
+    for (size_t i = 0; i < 12; ++i)
+        text += string(i % 4, 'a') + "\xd1\x88" + "\xe6\x97\xa5" + "\xf0\x9f\x98\x80" + string(i % 3, 'z') + "\xc3\xa9";
+    for (size_t offset = 0; offset < 32; ++offset) {
+        if (utf8::internal::is_trail(text[offset]))
+            continue;
+        const string part = text.substr(offset);
+        u16string expected, from_pointer;
+        EXPECT_EQ (utf8to16_outcome(part.begin(), part.end(), expected), 0);
+        EXPECT_EQ (utf8to16_outcome(part.data(), part.data() + part.size(), from_pointer), 0);
+        EXPECT_TRUE (from_pointer == expected);
+        u16string unchecked_result(part.size(), u'\0');
+        unchecked_result.resize(static_cast<size_t>(
+            utf8::unchecked::utf8to16(part.data(), part.data() + part.size(), &unchecked_result[0]) - &unchecked_result[0]));
+        EXPECT_TRUE (unchecked_result == expected);
+    }
+    const char bad_octets[] = {'\x80', '\xc0', '\xc3', '\xe0', '\xed', '\xf0', '\xf4', '\xf5', '\xff', 'a'};
+    for (size_t i = 0; i < 64; ++i) {
+        for (size_t j = 0; j < sizeof(bad_octets); ++j) {
+            string invalid = text;
+            invalid[i] = bad_octets[j];
+            u16string expected, from_pointer;
+            const int expected_outcome = utf8to16_outcome(invalid.begin(), invalid.end(), expected);
+            EXPECT_EQ (utf8to16_outcome(invalid.data(), invalid.data() + invalid.size(), from_pointer), expected_outcome);
+            EXPECT_TRUE (from_pointer == expected);
+        }
+    }
+}
+
+TEST(CheckedAPITests, test_long_transcoding)
+{
+    // Long contiguous input goes through the vectorized kernels where the CPU
+    // has them; sequences and surrogate pairs straddle the block boundaries.
+    const string text = mixed_text();
+    const char* start = text.c_str();
+    const char* end = start + text.size();
+    u16string from_pointer16, from_iterator16;
+    utf8to16(start, end, back_inserter(from_pointer16));
+    utf8to16(text.begin(), text.end(), back_inserter(from_iterator16));
+    EXPECT_TRUE (from_pointer16 == from_iterator16);
+
+    string back_from_pointer, back_from_iterator;
+    utf16to8(from_pointer16.data(), from_pointer16.data() + from_pointer16.size(), back_inserter(back_from_pointer));
+    utf16to8(from_pointer16.begin(), from_pointer16.end(), back_inserter(back_from_iterator));
+    EXPECT_EQ (back_from_pointer, text);
+    EXPECT_EQ (back_from_iterator, text);
+
+    // A lone surrogate far into the input
+    u16string broken = from_pointer16;
+    broken[200] = 0xdc00;
+    string partial;
+    EXPECT_THROW (utf16to8(broken.data(), broken.data() + broken.size(), back_inserter(partial)), invalid_utf16);
+    broken = from_pointer16;
+    broken.insert(broken.begin() + 150, 1, static_cast<char16_t>(0xd800));
+    broken.insert(broken.begin() + 151, 1, static_cast<char16_t>(0x61));
+    EXPECT_THROW (utf16to8(broken.data(), broken.data() + broken.size(), back_inserter(partial)), invalid_utf16);
+    u16string truncated = from_pointer16.substr(0, from_pointer16.size() - 1);
+    EXPECT_THROW (utf16to8(truncated.data(), truncated.data() + truncated.size(), back_inserter(partial)), invalid_utf16);
+
+    u32string from_pointer32, from_iterator32;
+    utf8to32(start, end, back_inserter(from_pointer32));
+    utf8to32(text.begin(), text.end(), back_inserter(from_iterator32));
+    EXPECT_TRUE (from_pointer32 == from_iterator32);
+    string back_from_utf32;
+    utf32to8(from_pointer32.data(), from_pointer32.data() + from_pointer32.size(), back_inserter(back_from_utf32));
+    EXPECT_EQ (back_from_utf32, text);
+    u32string broken32 = from_pointer32;
+    broken32[100] = 0xdfff;
+    EXPECT_THROW (utf32to8(broken32.data(), broken32.data() + broken32.size(), back_inserter(partial)), invalid_code_point);
+    broken32[100] = 0x110000;
+    EXPECT_THROW (utf32to8(broken32.data(), broken32.data() + broken32.size(), back_inserter(partial)), invalid_code_point);
+}
+
+TEST(CheckedAPITests, test_output_lengths)
+{
+    const char utf8_with_surrogates[] = "\xe6\x97\xa5\xd1\x88\xf0\x9d\x84\x9e";
+    EXPECT_EQ (utf16_length_from_utf8(utf8_with_surrogates, utf8_with_surrogates + 9), 4);
+    EXPECT_EQ (utf32_length_from_utf8(utf8_with_surrogates, utf8_with_surrogates + 9), 3);
+    const list<char> utf8_list(utf8_with_surrogates, utf8_with_surrogates + 9);
+    EXPECT_EQ (utf16_length_from_utf8(utf8_list.begin(), utf8_list.end()), 4);
+    EXPECT_EQ (utf32_length_from_utf8(utf8_list.begin(), utf8_list.end()), 3);
+
+    // Long enough for the vectorized counters, with the blocks ending mid-sequence
+    const string text = mixed_text();
+    vector<utfchar16_t> utf16;
+    vector<utfchar32_t> utf32;
+    mixed_text_transcodings(utf16, utf32);
+    EXPECT_EQ (utf16_length_from_utf8(text), utf16.size());
+    EXPECT_EQ (utf32_length_from_utf8(text), utf32.size());
+    EXPECT_EQ (utf8_length_from_utf16(&utf16[0], &utf16[0] + utf16.size()), text.size());
+    EXPECT_EQ (utf8_length_from_utf16(utf16.begin(), utf16.end()), text.size());
+    EXPECT_EQ (utf8_length_from_utf32(&utf32[0], &utf32[0] + utf32.size()), text.size());
+    EXPECT_EQ (utf8_length_from_utf32(utf32.begin(), utf32.end()), text.size());
+
+    // Invalid input: enough room for what the checked conversion writes
+    string invalid = text;
+    invalid[100] = static_cast<char>(0xff);
+    vector<utfchar16_t> partial;
+    EXPECT_THROW (utf8to16(invalid.begin(), invalid.end(), back_inserter(partial)), invalid_utf8);
+    EXPECT_TRUE (partial.size() <= utf16_length_from_utf8(invalid));
+}
+
+TEST(CheckedAPITests, test_bounded_conversions)
+{
+    const string text = mixed_text();
+    vector<utfchar16_t> utf16;
+    vector<utfchar32_t> utf32;
+    mixed_text_transcodings(utf16, utf32);
+
+    // All at once
+    vector<utfchar16_t> out16(utf16.size());
+    conversion_result result = convert_utf8_to_utf16(text.data(), text.size(), &out16[0], out16.size());
+    EXPECT_EQ (result.status, conversion_ok);
+    EXPECT_EQ (result.read, text.size());
+    EXPECT_EQ (result.written, utf16.size());
+    EXPECT_TRUE (out16 == utf16);
+
+    // Resumed on small buffers, stopping between the code points
+    vector<utfchar16_t> resumed16;
+    utfchar16_t buffer16[5];
+    for (size_t read = 0; read < text.size(); read += result.read) {
+        result = convert_utf8_to_utf16(text.data() + read, text.size() - read, buffer16, 5);
+        EXPECT_TRUE (result.written > 3);
+        EXPECT_FALSE (internal::is_lead_surrogate(buffer16[result.written - 1]));
+        resumed16.insert(resumed16.end(), buffer16, buffer16 + result.written);
+    }
+    EXPECT_TRUE (resumed16 == utf16);
+    string resumed8;
+    char buffer8[9];
+    for (size_t read = 0; read < utf16.size(); read += result.read) {
+        result = convert_utf16_to_utf8(&utf16[0] + read, utf16.size() - read, buffer8, 9);
+        resumed8.append(buffer8, result.written);
+    }
+    EXPECT_EQ (resumed8, text);
+    vector<utfchar32_t> resumed32;
+    utfchar32_t buffer32[3];
+    for (size_t read = 0; read < text.size(); read += result.read) {
+        result = convert_utf8_to_utf32(text.data() + read, text.size() - read, buffer32, 3);
+        resumed32.insert(resumed32.end(), buffer32, buffer32 + result.written);
+    }
+    EXPECT_TRUE (resumed32 == utf32);
+    resumed8.clear();
+    for (size_t read = 0; read < utf32.size(); read += result.read) {
+        result = convert_utf32_to_utf8(&utf32[0] + read, utf32.size() - read, buffer8, 9);
+        resumed8.append(buffer8, result.written);
+    }
+    EXPECT_EQ (resumed8, text);
+
+    // No room for a surrogate pair
+    result = convert_utf8_to_utf16("\xf0\x9d\x84\x9e", 4, buffer16, 1);
+    EXPECT_EQ (result.status, conversion_output_full);
+    EXPECT_EQ (result.read, 0u);
+    EXPECT_EQ (result.written, 0u);
+
+    // The input ends within a sequence, or continues with an invalid one
+    result = convert_utf8_to_utf16(text.data(), text.size() - 2, &out16[0], out16.size());
+    EXPECT_EQ (result.status, conversion_incomplete);
+    EXPECT_EQ (result.read, text.size() - 4);
+    string invalid = text;
+    invalid[100] = static_cast<char>(0xff);
+    result = convert_utf8_to_utf32(invalid.data(), invalid.size(), &utf32[0], utf32.size());
+    EXPECT_EQ (result.status, conversion_invalid);
+    EXPECT_EQ (result.read, 100u);
+    result = convert_utf16_to_utf8(&utf16[0], utf16.size() - 1, &resumed8[0], resumed8.size());
+    EXPECT_EQ (result.status, conversion_incomplete);
+    EXPECT_EQ (result.read, utf16.size() - 2);
+    utf16[60] = 0xdc00;
+    result = convert_utf16_to_utf8(&utf16[0], utf16.size(), &resumed8[0], resumed8.size());
+    EXPECT_EQ (result.status, conversion_invalid);
+    EXPECT_EQ (result.read, 60u);
+    utf32[30] = 0x110000;
+    result = convert_utf32_to_utf8(&utf32[0], utf32.size(), &resumed8[0], resumed8.size());
+    EXPECT_EQ (result.status, conversion_invalid);
+    EXPECT_EQ (result.read, 30u);
+}
+
+TEST(CheckedAPITests, test_active_implementation)
+{
+    const string name = active_implementation();
+    EXPECT_TRUE (name == "avx512-vbmi2" || name == "avx512" || name == "avx2" || name == "sse4.2" || name == "scalar");
+    EXPECT_EQ (name, string(active_implementation()));
 }
 
 TEST(CheckedAPITests, test_utf32to8)
@@ -226,6 +554,207 @@ TEST(CheckedAPITests, test_utf8to16)
     EXPECT_EQ (utf16result[3], 0xdd1e);
 }
 
+TEST(CheckedAPITests, test_try_transcoding)
+{
+    const char* text = "a\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    vector<unsigned short> utf16result;
+    transcoding_result<back_insert_iterator<vector<unsigned short> > > result16 =
+        try_utf8to16(text, text + 10, back_inserter(utf16result));
+    EXPECT_EQ (result16.error, internal::UTF8_OK);
+    EXPECT_EQ (result16.offset, 10u);
+    EXPECT_EQ (utf16result.size(), 5u);
+
+    // Long enough for the vectorized kernels; everything before the
+    // invalid sequence is converted
+    string long_text;
+    for (size_t i = 0; i < 300; ++i)
+        long_text += string(text + i % 2, text + 10);
+    vector<unsigned int> expected;
+    utf8to32(long_text.begin(), long_text.end(), back_inserter(expected));
+    vector<unsigned int> utf32result(expected.size());
+    transcoding_result<unsigned int*> result32 = try_utf8to32(long_text.data(), long_text.data() + long_text.size(), &utf32result[0]);
+    EXPECT_EQ (result32.error, internal::UTF8_OK);
+    EXPECT_EQ (result32.offset, long_text.size());
+    EXPECT_EQ (result32.out, &utf32result[0] + utf32result.size());
+    EXPECT_TRUE (utf32result == expected);
+
+    const size_t position = long_text.find('a', 1000);
+    string invalid = long_text;
+    invalid[position] = '\xff';
+    result32 = try_utf8to32(invalid.data(), invalid.data() + invalid.size(), &utf32result[0]);
+    EXPECT_EQ (result32.error, internal::INVALID_LEAD);
+    EXPECT_EQ (result32.offset, position);
+    const size_t converted = utf32_length_from_utf8(long_text.data(), long_text.data() + position);
+    EXPECT_EQ (result32.out, &utf32result[0] + converted);
+    utf16result.clear();
+    result16 = try_utf8to16(invalid.begin(), invalid.end(), back_inserter(utf16result));
+    EXPECT_EQ (result16.error, internal::INVALID_LEAD);
+    EXPECT_EQ (result16.offset, position);
+    EXPECT_EQ (utf16result.size(), utf16_length_from_utf8(long_text.data(), long_text.data() + position));
+
+    const char* truncated = "ab\xe6\x97";
+    utf16result.clear();
+    result16 = try_utf8to16(truncated, truncated + 4, back_inserter(utf16result));
+    EXPECT_EQ (result16.error, internal::NOT_ENOUGH_ROOM);
+    EXPECT_EQ (result16.offset, 2u);
+    EXPECT_EQ (utf16result.size(), 2u);
+}
+
+TEST(CheckedAPITests, test_error_policies)
+{
+    // Long enough for the vectorized kernels, with invalid sequences in between
+    const string text = "a\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    string dirty;
+    for (size_t i = 0; i < 100; ++i)
+        dirty += text + (i % 3 == 0 ? "\xe6\x97" : i % 3 == 1 ? "\xff" : "\xc0\xaf");
+    dirty += "\xf0\x9d";
+
+    // The same as replacing the invalid sequences first
+    string fixed;
+    replace_invalid(dirty.begin(), dirty.end(), back_inserter(fixed));
+    vector<unsigned short> expected16;
+    utf8to16(fixed.begin(), fixed.end(), back_inserter(expected16));
+    vector<unsigned short> utf16result;
+    utf8to16(dirty.data(), dirty.data() + dirty.size(), back_inserter(utf16result), on_error::replace());
+    EXPECT_TRUE (utf16result == expected16);
+    vector<unsigned int> expected32;
+    utf8to32(fixed.begin(), fixed.end(), back_inserter(expected32));
+    vector<unsigned int> utf32result;
+    utf8to32(dirty.begin(), dirty.end(), back_inserter(utf32result), on_error::replace());
+    EXPECT_TRUE (utf32result == expected32);
+
+    fixed.clear();
+    replace_invalid(dirty.begin(), dirty.end(), back_inserter(fixed), '?');
+    utf32result.clear();
+    utf8to32(dirty.data(), dirty.data() + dirty.size(), back_inserter(utf32result), on_error::replace('?'));
+    string utf8result;
+    utf32to8(utf32result.begin(), utf32result.end(), back_inserter(utf8result));
+    EXPECT_EQ (utf8result, fixed);
+
+    utf16result.clear();
+    utf8to16(dirty.data(), dirty.data() + dirty.size(), back_inserter(utf16result), on_error::skip());
+    EXPECT_EQ (utf16result.size(), 500u);
+
+    const transcoding_result<back_insert_iterator<vector<unsigned short> > > stopped =
+        utf8to16(dirty.begin(), dirty.end(), back_inserter(utf16result), on_error::stop());
+    EXPECT_EQ (stopped.error, internal::INCOMPLETE_SEQUENCE);
+    EXPECT_EQ (stopped.offset, 10u);
+    EXPECT_THROW (utf8to32(dirty.begin(), dirty.end(), back_inserter(utf32result), on_error::throw_exception()), invalid_utf8);
+
+    // Lone surrogates and invalid code points are replaced one by one
+    vector<unsigned short> utf16 = expected16;
+    utf16[1] = 0xdc00;
+    utf16[2] = 0xd800;
+    utf16.push_back(0xd834);
+    utf8result.clear();
+    utf16to8(utf16.data(), utf16.data() + utf16.size(), back_inserter(utf8result), on_error::replace());
+    EXPECT_EQ (utf8result.substr(0, 11), "a\xef\xbf\xbd\xef\xbf\xbd\xf0\x9d\x84\x9e");
+    EXPECT_EQ (utf8result.substr(utf8result.size() - 3), "\xef\xbf\xbd");
+    const transcoding_result<back_insert_iterator<string> > stopped8 =
+        utf16to8(utf16.begin(), utf16.end(), back_inserter(utf8result), on_error::stop());
+    EXPECT_EQ (stopped8.error, internal::INVALID_LEAD);
+    EXPECT_EQ (stopped8.offset, 1u);
+    EXPECT_THROW (utf16to8(utf16.begin(), utf16.end(), back_inserter(utf8result), on_error::throw_exception()), invalid_utf16);
+
+    vector<unsigned int> utf32 = expected32;
+    utf32[200] = 0x110000;
+    utf8result.clear();
+    utf32to8(utf32.data(), utf32.data() + utf32.size(), back_inserter(utf8result), on_error::skip());
+    string expected8;
+    utf32to8(expected32.begin(), expected32.end(), back_inserter(expected8));
+    const size_t removed = utf8_length_from_utf32(&expected32[200], &expected32[201]);
+    EXPECT_EQ (utf8result.size(), expected8.size() - removed);
+    EXPECT_THROW (utf32to8(utf32.begin(), utf32.end(), back_inserter(utf8result), on_error::replace(0xd800)), invalid_code_point);
+}
+
+TEST(CheckedAPITests, test_byte_order)
+{
+    const char* text = "a\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    string utf16be, utf16le, utf32be, utf32le;
+    utf8to16be(text, text + 10, back_inserter(utf16be));
+    utf8to16le(text, text + 10, back_inserter(utf16le));
+    utf8to32be(text, text + 10, back_inserter(utf32be));
+    utf8to32le(text, text + 10, back_inserter(utf32le));
+    EXPECT_EQ (utf16be, string("\0a\x04\x48\x65\xe5\xd8\x34\xdd\x1e", 10));
+    EXPECT_EQ (utf16le, string("a\0\x48\x04\xe5\x65\x34\xd8\x1e\xdd", 10));
+    EXPECT_EQ (utf32be, string("\0\0\0a\0\0\x04\x48\0\0\x65\xe5\0\x01\xd1\x1e", 16));
+    EXPECT_EQ (utf32le, string("a\0\0\0\x48\x04\0\0\xe5\x65\0\0\x1e\xd1\x01\0", 16));
+
+    // Long enough for the vectorized kernels, back and forth
+    string long_text;
+    for (size_t i = 0; i < 300; ++i)
+        long_text += string(text + i % 2, text + 10);
+    vector<char> bytes;
+    utf8to16be(long_text.begin(), long_text.end(), back_inserter(bytes));
+    string utf8result;
+    utf16be_to8(bytes.begin(), bytes.end(), back_inserter(utf8result));
+    EXPECT_TRUE (utf8result == long_text);
+    bytes.resize(4 * long_text.size());
+    const char* long_start = long_text.data();
+    const char* long_end = long_start + long_text.size();
+    char* bytes_end = utf8to16le(long_start, long_end, &bytes[0]);
+    utf8result.clear();
+    utf16le_to8(&bytes[0], bytes_end, back_inserter(utf8result));
+    EXPECT_TRUE (utf8result == long_text);
+    bytes_end = utf8to32be(long_start, long_end, &bytes[0]);
+    utf8result.clear();
+    utf32be_to8(&bytes[0], bytes_end, back_inserter(utf8result));
+    EXPECT_TRUE (utf8result == long_text);
+    bytes_end = utf8to32le(long_start, long_end, &bytes[0]);
+    utf8result.clear();
+    utf32le_to8(&bytes[0], bytes_end, back_inserter(utf8result));
+    EXPECT_TRUE (utf8result == long_text);
+
+    // A lone surrogate, a code point out of range and a code unit cut short
+    string lone = utf16be;
+    lone.erase(8);
+    EXPECT_THROW (utf16be_to8(lone.begin(), lone.end(), back_inserter(utf8result)), invalid_utf16);
+    const string too_large("\0\x11\0\0", 4);
+    EXPECT_THROW (utf32be_to8(too_large.begin(), too_large.end(), back_inserter(utf8result)), invalid_code_point);
+    EXPECT_THROW (utf16le_to8(bytes.begin(), bytes.begin() + 3, back_inserter(utf8result)), not_enough_room);
+    EXPECT_THROW (utf32le_to8(bytes.begin(), bytes.begin() + 6, back_inserter(utf8result)), not_enough_room);
+    const char* invalid = "a\x80";
+    EXPECT_THROW (utf8to16be(invalid, invalid + 2, back_inserter(utf16be)), invalid_utf8);
+}
+
+TEST(CheckedAPITests, test_latin1)
+{
+    const char latin1[] = "caf\xe9 \xff\x80";
+    string utf8result;
+    latin1to8(latin1, latin1 + 7, back_inserter(utf8result));
+    EXPECT_EQ (utf8result, string("caf\xc3\xa9 \xc3\xbf\xc2\x80"));
+    string latin1result;
+    utf8tolatin1(utf8result.begin(), utf8result.end(), back_inserter(latin1result));
+    EXPECT_EQ (latin1result, string(latin1));
+
+    // Long enough for the vectorized kernels, with every octet value
+    string long_latin1;
+    for (unsigned int i = 0; i < 2000; ++i)
+        long_latin1 += static_cast<char>((i % 3) ? (i * 7) % 256 : 'a');
+    string long_utf8;
+    latin1to8(long_latin1.begin(), long_latin1.end(), back_inserter(long_utf8));
+    EXPECT_EQ (utf32_length_from_utf8(long_utf8.begin(), long_utf8.end()), long_latin1.size());
+    vector<char> long_result(long_latin1.size());
+    const char* long_start = long_utf8.data();
+    char* long_end = utf8tolatin1(long_start, long_start + long_utf8.size(), &long_result[0]);
+    EXPECT_EQ (long_end, &long_result[0] + long_result.size());
+    EXPECT_TRUE (string(long_result.begin(), long_result.end()) == long_latin1);
+
+    // Code points above 0xff do not fit
+    string too_wide = long_utf8;
+    size_t boundary = 1000;
+    while ((too_wide[boundary] & 0xc0) == 0x80)
+        ++boundary;
+    too_wide.insert(boundary, "\xc4\x80");
+    EXPECT_THROW (utf8tolatin1(too_wide.begin(), too_wide.end(), back_inserter(latin1result)), invalid_code_point);
+    too_wide = long_utf8 + "\xe6\x97\xa5";
+    EXPECT_THROW (utf8tolatin1(too_wide.data(), too_wide.data() + too_wide.size(), &long_result[0]), invalid_code_point);
+    const char* invalid = "a\x80";
+    EXPECT_THROW (utf8tolatin1(invalid, invalid + 2, back_inserter(latin1result)), invalid_utf8);
+    const char* truncated = "a\xc3";
+    EXPECT_THROW (utf8tolatin1(truncated, truncated + 2, back_inserter(latin1result)), not_enough_room);
+}
+
 TEST(CheckedAPITests, test_replace_invalid)
 {
     char invalid_sequence[] = "a\x80\xe0\xa0\xc0\xaf\xed\xa0\x80z";
@@ -236,6 +765,112 @@ TEST(CheckedAPITests, test_replace_invalid)
     const char fixed_invalid_sequence[] = "a????z";
     EXPECT_EQ (sizeof(fixed_invalid_sequence), replace_invalid_result.size());
     EXPECT_TRUE (std::equal(replace_invalid_result.begin(), replace_invalid_result.begin() + sizeof(fixed_invalid_sequence), fixed_invalid_sequence));
+
+    // The string overloads size their result up front, for every length of
+    // the replacement and with a truncated sequence at the end
+    string long_invalid;
+    for (int i = 0; i < 30; ++i)
+        long_invalid += string("text \xd1\x88\xd0\xbd ") + invalid_sequence + "\xfa";
+    long_invalid += "\xf0\x9d\x84";
+    const utfchar32_t replacements[] = {'?', 0x448, 0xfffd, 0x1d11e};
+    for (size_t i = 0; i < 4; ++i) {
+        string expected;
+        replace_invalid(long_invalid.begin(), long_invalid.end(), back_inserter(expected), replacements[i]);
+        EXPECT_EQ (replace_invalid(long_invalid, replacements[i]), expected);
+    }
+    string expected;
+    replace_invalid(long_invalid.begin(), long_invalid.end(), back_inserter(expected));
+    EXPECT_EQ (replace_invalid(long_invalid), expected);
+    EXPECT_EQ (replace_invalid(expected), expected);
+    // Contiguous input and output: the valid runs are copied in one block
+    string buffer(long_invalid.size() * 3, '\0');
+    const char* const buffer_end = replace_invalid(long_invalid.data(), long_invalid.data() + long_invalid.size(), &buffer[0]);
+    EXPECT_EQ (string(buffer.data(), buffer_end), expected);
+    EXPECT_THROW (replace_invalid(long_invalid, 0xd800), invalid_code_point);
+}
+
+struct invalid_sequence_counter {
+    size_t count;
+    size_t octets;
+    invalid_sequence_counter() : count(0), octets(0) {}
+    void operator () (const invalid_sequence& sequence) { ++count; octets += sequence.length; }
+};
+
+TEST(CheckedAPITests, test_sanitize)
+{
+    // Valid text is left alone, without a reallocation
+    string valid = "text \xd1\x88\xd0\xbd \xe6\x97\xa5\xf0\x9d\x84\x9e";
+    const char* const data = valid.data();
+    EXPECT_EQ (sanitize(valid), 0u);
+    EXPECT_EQ (valid.data(), data);
+
+    // The replacements are longer or shorter than the sequences they replace
+    string invalid;
+    for (int i = 0; i < 30; ++i)
+        invalid += valid + "\x80\xe0\xa0\xc0\xaf\xed\xa0\x80\xfa";
+    invalid += "\xf0\x9d\x84";
+    const utfchar32_t replacements[] = {'?', 0x448, 0xfffd, 0x1d11e};
+    for (size_t i = 0; i < 4; ++i) {
+        string sanitized = invalid;
+        EXPECT_EQ (sanitize(sanitized, replacements[i]), 151u);
+        EXPECT_EQ (sanitized, replace_invalid(invalid, replacements[i]));
+    }
+    string sanitized = invalid;
+    sanitize(sanitized);
+    EXPECT_EQ (sanitized, replace_invalid(invalid));
+    EXPECT_THROW (sanitize(sanitized = invalid, 0xd800), invalid_code_point);
+
+    // A buffer only grows up to its capacity
+    char buffer[8] = "ab\x80\x80";
+    size_t length = 4;
+    EXPECT_EQ (sanitize(buffer, length, 8), 2u);
+    EXPECT_EQ (string(buffer, length), "ab\xef\xbf\xbd\xef\xbf\xbd");
+    char short_buffer[8] = "ab\x80\x80";
+    length = 4;
+    EXPECT_THROW (sanitize(short_buffer, length, 7), not_enough_room);
+    EXPECT_EQ (string(short_buffer, length), "ab\x80\x80");
+    EXPECT_EQ (sanitize(short_buffer, length, 4, '?'), 2u);
+    EXPECT_EQ (string(short_buffer, length), "ab??");
+}
+
+TEST(CheckedAPITests, test_find_all_invalid)
+{
+    const string invalid = "a\x80\xe0\xa0\xc0\xaf\xed\xa0\x80z\xfa\xe6\x97";
+    vector<invalid_sequence> found;
+    find_all_invalid(invalid.begin(), invalid.end(), back_inserter(found));
+    EXPECT_EQ (found.size(), 6u);
+    const size_t offsets[] = {1, 2, 4, 6, 10, 11};
+    const size_t lengths[] = {1, 2, 2, 3, 1, 2};
+    const internal::utf_error errors[] = {internal::INVALID_LEAD, internal::INCOMPLETE_SEQUENCE,
+        internal::OVERLONG_SEQUENCE, internal::INVALID_CODE_POINT, internal::INVALID_LEAD, internal::NOT_ENOUGH_ROOM};
+    for (size_t i = 0; i < found.size() && i < 6; ++i) {
+        EXPECT_EQ (found[i].offset, offsets[i]);
+        EXPECT_EQ (found[i].length, lengths[i]);
+        EXPECT_EQ (found[i].error, errors[i]);
+    }
+
+    // The cap
+    found.clear();
+    find_all_invalid(invalid.c_str(), invalid.c_str() + invalid.size(), back_inserter(found), 2);
+    EXPECT_EQ (found.size(), 2u);
+    EXPECT_EQ (found[1].offset, 2u);
+    const invalid_sequence_counter none = for_each_invalid(invalid.begin(), invalid.end(), invalid_sequence_counter(), 0);
+    EXPECT_EQ (none.count, 0u);
+
+    // The spans are the ones replace_invalid replaces, over long contiguous
+    // input as well as over a list
+    string long_invalid;
+    for (int i = 0; i < 20; ++i)
+        long_invalid += "ASCII \xd1\x88\xd0\xbd text " + invalid;
+    const list<char> long_invalid_list(long_invalid.begin(), long_invalid.end());
+    const invalid_sequence_counter counter = for_each_invalid(long_invalid.data(), long_invalid.data() + long_invalid.size(), invalid_sequence_counter());
+    const invalid_sequence_counter list_counter = for_each_invalid(long_invalid_list.begin(), long_invalid_list.end(), invalid_sequence_counter());
+    EXPECT_EQ (counter.count, 120u);
+    EXPECT_EQ (list_counter.count, counter.count);
+    EXPECT_EQ (list_counter.octets, counter.octets);
+    string replaced;
+    replace_invalid(long_invalid.begin(), long_invalid.end(), back_inserter(replaced), '?');
+    EXPECT_EQ (replaced.size(), long_invalid.size() - counter.octets + counter.count);
 }
 
 TEST(CheckedAPITests, test_find_invalid)
@@ -247,6 +882,191 @@ TEST(CheckedAPITests, test_find_invalid)
     EXPECT_EQ (invalid, utf_invalid + 5);
 }
 
+TEST(CheckedAPITests, test_find_invalid_long_input)
+{
+    // Long enough to go through the vectorized validator, with errors planted
+    // at every offset; the position must match the one found by the scalar
+    // code path, which is what a non-contiguous iterator gets.
+    string valid;
+    for (int i = 0; i < 8; ++i)
+        valid += "ASCII \xd1\x88\xd0\xbd\xd0\xb8 \xe6\x97\xa5\xe6\x9c\xac \xf0\x9f\x98\x80 text";
+    EXPECT_EQ (find_invalid(valid), string::npos);
+    const char bad_octets[] = {'\x80', '\xbf', '\xc0', '\xc3', '\xe0', '\xed', '\xf0', '\xf4', '\xf5', '\xff'};
+    for (size_t i = 0; i < valid.size(); ++i) {
+        for (size_t j = 0; j < sizeof(bad_octets); ++j) {
+            string invalid = valid;
+            invalid[i] = bad_octets[j];
+            const list<char> invalid_list(invalid.begin(), invalid.end());
+            const size_t expected = static_cast<size_t>(
+                std::distance(invalid_list.begin(), find_invalid(invalid_list.begin(), invalid_list.end())));
+            const size_t expected_index = (expected == invalid.size()) ? string::npos : expected;
+            EXPECT_EQ (find_invalid(invalid), expected_index);
+            const char* start = invalid.c_str();
+            EXPECT_EQ (find_invalid(start, start + invalid.size()), start + expected);
+        }
+        // A truncated sequence at the very end
+        const string truncated = valid.substr(0, i);
+        EXPECT_EQ (is_valid(truncated), is_valid(truncated.begin(), truncated.end()));
+    }
+}
+
+TEST(CheckedAPITests, test_stream_validator)
+{
+    // The text is fed in two and three chunks split at every offset, and
+    // byte by byte; the outcome must be the same as for the whole text at once.
+    const string valid = "a\xd1\x88\xe6\x97\xa5\xf0\x9f\x98\x80 z\xf4\x8f\xbf\xbf";
+    const char* texts[] = {
+        "a\xd1\x88\xe6\x97\xa5\xf0\x9f\x98\x80 z\xf4\x8f\xbf\xbf",
+        "a\xd1\x88\xe6\x97\xa5\xf0\x9f\x98 z",      // truncated 4-octet sequence
+        "a\xd1\x88\xe6\x97\xa5\xed\xa0\x80 z",      // surrogate
+        "a\xd1\x88\xe0\x80\xaf\xf0\x9f\x98\x80",    // overlong
+        "a\xd1\x88\xf4\x90\x80\x80",                // out of range
+        "a\xd1\x88\xe6\x97\xa5\xf0\x9f",            // truncated at the end
+        "a\xd1\x88\xe6\x97\xa5\xbf",                 // stray trail octet
+    };
+    for (size_t t = 0; t < sizeof(texts) / sizeof(texts[0]); ++t) {
+        const string text = texts[t];
+        const size_t expected = find_invalid(text);
+        const bool expected_valid = (expected == string::npos);
+        for (size_t i = 0; i <= text.size(); ++i) {
+            for (size_t j = i; j <= text.size(); ++j) {
+                utf8::stream_validator validator;
+                validator.feed(text.data(), i);
+                validator.feed(text.data() + i, j - i);
+                validator.feed(text.data() + j, text.size() - j);
+                EXPECT_EQ (validator.finish(), expected_valid);
+                EXPECT_EQ (validator.error_offset(), expected);
+            }
+        }
+        utf8::stream_validator validator;
+        for (size_t i = 0; i < text.size(); ++i)
+            validator.feed(text.data() + i, 1);
+        EXPECT_EQ (validator.finish(), expected_valid);
+        EXPECT_EQ (validator.error_offset(), expected);
+    }
+
+    // Errors are reported as soon as they are seen, and the rest is ignored
+    utf8::stream_validator validator;
+    EXPECT_TRUE (validator.feed(valid.data(), 2));
+    EXPECT_TRUE (validator.feed("\x88\xe6", 2));
+    EXPECT_FALSE (validator.feed("\x97\xff", 2));
+    EXPECT_EQ (validator.error_offset(), 3u);
+    EXPECT_FALSE (validator.feed(valid.data(), valid.size()));
+    EXPECT_FALSE (validator.finish());
+    EXPECT_EQ (validator.error_offset(), 3u);
+    validator.reset();
+    EXPECT_TRUE (validator.feed(valid.data(), valid.size()));
+    EXPECT_TRUE (validator.finish());
+    EXPECT_EQ (validator.error_offset(), string::npos);
+
+    // A chunk long enough for the vectorized validator, ending mid-sequence
+    string long_text;
+    for (int i = 0; i < 40; ++i)
+        long_text += "\xe6\x97\xa5";
+    utf8::stream_validator long_validator;
+    EXPECT_TRUE (long_validator.feed(long_text.data(), long_text.size() - 1));
+    EXPECT_TRUE (long_validator.feed(long_text.data() + long_text.size() - 1, 1));
+    EXPECT_TRUE (long_validator.finish());
+}
+
+TEST(CheckedAPITests, test_stream_transcoder)
+{
+    // The text is pushed in three chunks split at every offset; the output
+    // must be the same as for the whole text at once
+    string text = "a\xd1\x88\xe6\x97\xa5\xf0\x9f\x98\x80 z\xf4\x8f\xbf\xbf";
+    for (int i = 0; i < 6; ++i)
+        text += text;
+    vector<utfchar16_t> utf16;
+    utf8to16(text.begin(), text.end(), back_inserter(utf16));
+    for (size_t i = 0; i <= 20; ++i) {
+        for (size_t j = i; j <= text.size(); j += 13) {
+            vector<utfchar16_t> out16;
+            stream_transcoder<char, utfchar16_t> to_utf16;
+            to_utf16.push(text.data(), i, back_inserter(out16));
+            to_utf16.push(text.data() + i, j - i, back_inserter(out16));
+            to_utf16.push(text.data() + j, text.size() - j, back_inserter(out16));
+            to_utf16.finish();
+            EXPECT_TRUE (out16 == utf16);
+
+            string out8;
+            stream_transcoder<utfchar16_t, char> to_utf8;
+            const size_t k = j * utf16.size() / text.size();
+            const size_t l = (k / 2 + i < k) ? k / 2 + i : k;
+            to_utf8.push(&utf16[0], l, back_inserter(out8));
+            to_utf8.push(&utf16[0] + l, k - l, back_inserter(out8));
+            to_utf8.push(&utf16[0] + k, utf16.size() - k, back_inserter(out8));
+            to_utf8.finish();
+            EXPECT_EQ (out8, text);
+        }
+    }
+
+    // Octet by octet and unit by unit, into pointers
+    vector<utfchar16_t> out16(utf16.size());
+    utfchar16_t* result16 = &out16[0];
+    stream_transcoder<char, utfchar16_t> to_utf16;
+    for (size_t i = 0; i < text.size(); ++i)
+        result16 = to_utf16.push(text.data() + i, 1, result16);
+    EXPECT_EQ (static_cast<size_t>(result16 - &out16[0]), utf16.size());
+    EXPECT_TRUE (out16 == utf16);
+    string out8(text.size(), ' ');
+    char* result8 = &out8[0];
+    stream_transcoder<utfchar16_t, char> to_utf8;
+    for (size_t i = 0; i < utf16.size(); ++i)
+        result8 = to_utf8.push(&utf16[0] + i, 1, result8);
+    EXPECT_EQ (out8, text);
+
+    // Errors, within a chunk and across the chunks
+    EXPECT_THROW (to_utf16.push("\xe6\x97 ", 3, result16), invalid_utf8);
+    to_utf16.reset();
+    to_utf16.push("\xf0\x9f", 2, result16);
+    EXPECT_THROW (to_utf16.push("\x98 ", 2, result16), invalid_utf8);
+    to_utf16.reset();
+    EXPECT_THROW (to_utf16.push("\xf0\x9f\xf0", 3, result16), invalid_utf8);
+    to_utf16.reset();
+    // A surrogate or an out of range code point split between the chunks
+    // is reported as for the whole text
+    to_utf16.push("a\xed", 2, result16);
+    EXPECT_THROW (to_utf16.push("\xa0\x80z", 3, result16), invalid_code_point);
+    EXPECT_THROW (utf8to16(string("a\xed\xa0\x80z")), invalid_code_point);
+    to_utf16.reset();
+    to_utf16.push("\xf4", 1, result16);
+    EXPECT_THROW (to_utf16.push("\x90\x80\x80", 3, result16), invalid_code_point);
+    EXPECT_THROW (utf8to16(string("\xf4\x90\x80\x80")), invalid_code_point);
+    to_utf16.reset();
+    to_utf16.push("\xf0\x9f\x98", 3, result16);
+    EXPECT_THROW (to_utf16.finish(), not_enough_room);
+    to_utf16.reset();
+    to_utf16.finish();
+    const utfchar16_t lead_surrogate = 0xd834;
+    const utfchar16_t trail_surrogate = 0xdd1e;
+    to_utf8.push(&lead_surrogate, 1, result8);
+    EXPECT_THROW (to_utf8.push(&lead_surrogate, 1, result8), invalid_utf16);
+    to_utf8.reset();
+    EXPECT_THROW (to_utf8.push(&trail_surrogate, 1, result8), invalid_utf16);
+    to_utf8.push(&lead_surrogate, 1, result8);
+    EXPECT_THROW (to_utf8.finish(), invalid_utf16);
+    // Two lead surrogates at the end of a chunk: the second one is reported,
+    // as for the whole text
+    to_utf8.reset();
+    const utfchar16_t two_leads[] = {0xd974, 0xdb81};
+    utfchar16_t reported = 0;
+    try {
+        to_utf8.push(two_leads, 2, result8);
+    }
+    catch (const invalid_utf16& e) {
+        reported = e.utf16_word();
+    }
+    EXPECT_EQ (reported, 0xdb81);
+    reported = 0;
+    try {
+        utf16to8(two_leads, two_leads + 2, result8);
+    }
+    catch (const invalid_utf16& e) {
+        reported = e.utf16_word();
+    }
+    EXPECT_EQ (reported, 0xdb81);
+}
+
 TEST(CheckedAPITests, test_is_valid)
 {
     char utf_invalid[] = "\xe6\x97\xa5\xd1\x88\xfa";
@@ -1,6 +1,13 @@
 #include "ftest.h"
 #include "utf8.h"
+#include "utf8/parallel.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 using namespace utf8;
 using namespace std;
 
@@ -50,11 +57,22 @@ TEST(CPP11APITests, test_utf16to8)
     u16string utf16string = {0x41, 0x0448, 0x65e5, 0xd834, 0xdd1e};
     string u = utf16to8(utf16string);
     EXPECT_EQ (u.size(), 10);
+    EXPECT_EQ (utf8_length_from_utf16(utf16string), 10);
 
     u16string h16 = u"h!";
     string h8;
     utf8::unchecked::utf16to8(h16.begin(), h16.end(), std::back_inserter(h8));
     EXPECT_EQ (h8, "h!");
+
+    // Long enough for the vectorized kernels, with a pair across every block edge
+    u16string long16;
+    for (size_t i = 0; i < 40; ++i)
+        long16 += u16string(i % 9, u'ш') + u"ab" + u16string(i % 5, u'日') + u"\U0001d11e";
+    string long8;
+    utf16to8(long16.begin(), long16.end(), back_inserter(long8));
+    EXPECT_EQ (utf16to8(long16), long8);
+    long16[long16.size() / 2] = 0xdc00;
+    EXPECT_THROW (utf16to8(long16), invalid_utf16);
 }
 
 TEST(CPP11APITests, test_utf8to16)
@@ -67,6 +85,9 @@ TEST(CPP11APITests, test_utf8to16)
     // Just to make sure it compiles with string literals
     utf8to16(u8"simple");
     utf8to16("simple");
+    // Nothing to write, but still invalid
+    EXPECT_THROW (utf8to16(string("\x80")), invalid_utf8);
+    EXPECT_THROW (utf8to32(string("\xe6\x97")), not_enough_room);
 }
 
 TEST(CPP11APITests, test_utf32to8)
@@ -74,6 +95,7 @@ TEST(CPP11APITests, test_utf32to8)
     u32string utf32string = {0x448, 0x65E5, 0x10346};
     string utf8result = utf32to8(utf32string);
     EXPECT_EQ (utf8result.size(), 9);
+    EXPECT_EQ (utf8_length_from_utf32(utf32string), 9);
 }
 
 TEST(CPP11APITests, test_utf8to32)
@@ -90,6 +112,78 @@ TEST(CPP11APITests, test_find_invalid)
     EXPECT_EQ (invalid, 5);
 }
 
+TEST(CPP11APITests, test_parallel_find_invalid)
+{
+    // Split points at every offset: the chunks must agree with a single pass
+    const string text = "a\xd1\x88\xe6\x97\xa5\xf0\x9f\x98\x80 z\xe6\x97\xa5";
+    const char bad_octets[] = {'\x80', '\xc3', '\xe0', '\xf4', '\xff'};
+    for (size_t i = 0; i <= text.size(); ++i) {
+        for (size_t j = 0; j <= sizeof(bad_octets); ++j) {
+            string invalid = text;
+            if (i < text.size() && j < sizeof(bad_octets))
+                invalid[i] = bad_octets[j];
+            else if (j < sizeof(bad_octets))
+                continue;
+            const char* start = invalid.data();
+            const char* end = start + invalid.size();
+            for (size_t tasks = 1; tasks <= invalid.size(); ++tasks) {
+                internal::parallel_validation validation(start, end, tasks);
+                for (size_t task = tasks; task > 0; --task)
+                    validation.validate(task - 1);
+                EXPECT_EQ (validation.result(), find_invalid(start, end));
+            }
+        }
+    }
+
+    // Long enough for several threads
+    string long_text;
+    while (long_text.size() < 1000000)
+        long_text += text;
+    EXPECT_EQ (find_invalid(long_text, 4), string::npos);
+    EXPECT_TRUE (is_valid(long_text, 0));
+    const size_t positions[] = {1, 400001, 999990};
+    for (size_t position : positions) {
+        string invalid = long_text;
+        invalid[position] = '\xff';
+        invalid[position + 5] = '\xff';
+        const size_t expected = find_invalid(invalid);
+        EXPECT_EQ (find_invalid(invalid, 4), expected);
+        EXPECT_FALSE (is_valid(invalid.data(), invalid.data() + invalid.size(), 3));
+        vector<future<void>> futures;
+        const char* found = find_invalid(invalid.data(), invalid.data() + invalid.size(), 8,
+            [&futures](function<void()> task) { futures.push_back(async(launch::async, task)); });
+        EXPECT_EQ (static_cast<size_t>(found - invalid.data()), expected);
+    }
+
+    // An executor that refuses the third task: the two it took must be done
+    // before the exception leaves find_invalid
+    atomic<bool> returned(false);
+    atomic<int> late_tasks(0);
+    vector<future<void>> futures;
+    int calls = 0;
+    try {
+        find_invalid(long_text.data(), long_text.data() + long_text.size(), 8,
+            [&](function<void()> task) {
+                if (++calls == 3)
+                    throw runtime_error("executor is full");
+                futures.push_back(async(launch::async, [task, &returned, &late_tasks]() {
+                    this_thread::sleep_for(chrono::milliseconds(20));
+                    if (returned)
+                        ++late_tasks;
+                    else
+                        task();
+                }));
+            });
+    } catch (const runtime_error&) {
+        returned = true;
+    }
+    for (size_t i = 0; i < futures.size(); ++i)
+        futures[i].wait();
+    EXPECT_TRUE (returned);
+    EXPECT_EQ (calls, 3);
+    EXPECT_EQ (late_tasks, 0);
+}
+
 TEST(CPP11APITests, test_is_valid)
 {
     string utf_invalid = "\xe6\x97\xa5\xd1\x88\xfa";
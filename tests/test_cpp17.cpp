@@ -13,6 +13,7 @@ TEST(CPP17APITests, test_utf16to8)
     u16string_view utf16stringview(utf16string);
     string u = utf16to8(utf16stringview);
     EXPECT_EQ (u.size(), 10);
+    EXPECT_EQ (utf8_length_from_utf16(utf16stringview), 10);
 }
 
 TEST(CPP17APITests, test_utf8to16)
@@ -20,6 +21,8 @@ TEST(CPP17APITests, test_utf8to16)
     string_view utf8_with_surrogates = "\xe6\x97\xa5\xd1\x88\xf0\x9d\x84\x9e";
     u16string utf16result = utf8to16(utf8_with_surrogates);
     EXPECT_EQ (utf16result.size(), 4);
+    EXPECT_EQ (utf16_length_from_utf8(utf8_with_surrogates), 4);
+    EXPECT_EQ (utf32_length_from_utf8(utf8_with_surrogates), 3);
     EXPECT_EQ (utf16result[2], 0xd834);
     EXPECT_EQ (utf16result[3], 0xdd1e);
 }
@@ -39,6 +42,15 @@ TEST(CPP17APITests, test_utf8to32)
     EXPECT_EQ (utf32result.size(), 2);
 }
 
+TEST(CPP17APITests, test_latin1)
+{
+    string_view latin1 = "caf\xe9";
+    string utf8result = latin1to8(latin1);
+    EXPECT_EQ (utf8result, "caf\xc3\xa9");
+    EXPECT_EQ (utf8tolatin1(string_view(utf8result)), latin1);
+    EXPECT_THROW (utf8tolatin1(string_view("\xe6\x97\xa5")), invalid_code_point);
+}
+
 TEST(CPP17APITests, test_find_invalid)
 {
     string_view utf_invalid = "\xe6\x97\xa5\xd1\x88\xfa";
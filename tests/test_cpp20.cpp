@@ -13,6 +13,16 @@ TEST(CPP20APITests, test_utf16tou8)
     EXPECT_EQ (u.size(), 10);
     u = utf16tou8(utf16stringview);
     EXPECT_EQ (u.size(), 10);
+
+    // Long enough for the vectorized kernels, written straight into the result
+    u16string long16;
+    for (int i = 0; i < 40; ++i)
+        long16 += utf16string;
+    u8string long8 = utf16tou8(long16);
+    EXPECT_EQ (long8.size(), 400);
+    EXPECT_TRUE (utf8to16(long8) == long16);
+    long16.back() = 0xd834;
+    EXPECT_THROW (utf16tou8(long16), invalid_utf16);
 }
 
 TEST(CPP20APITests, tes20t_utf8to16)
@@ -64,6 +74,9 @@ TEST(CPP20APITests, test_replace_invalid)
     EXPECT_TRUE (bvalid);
     const u8string fixed_invalid_sequence = reinterpret_cast<const char8_t*>("a????z");
     EXPECT_EQ(fixed_invalid_sequence, replace_invalid_result);
+    replace_invalid_result = replace_invalid(invalid_sequence);
+    EXPECT_EQ (replace_invalid_result.size(), 14);
+    EXPECT_TRUE (is_valid(replace_invalid_result));
 }
 
 TEST(CPP20APITests, test_starts_with_bom)
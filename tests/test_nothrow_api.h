@@ -0,0 +1,144 @@
+#ifndef UTF8_FOR_CPP_TEST_NOTHROW_H_9d2e6f3a_41b7_4c85_a0e3_7b5c1d8f2e64
+#define UTF8_FOR_CPP_TEST_NOTHROW_H_9d2e6f3a_41b7_4c85_a0e3_7b5c1d8f2e64
+
+#include "utf8/nothrow.h"
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+TEST(NothrowAPITests, test_append)
+{
+    char u[5] = {0,0,0,0,0};
+    utf8::nothrow::outcome<utf8::utfchar32_t, char*> appended = utf8::nothrow::append(0x0448, u);
+    EXPECT_EQ (appended.error, utf8::internal::UTF8_OK);
+    EXPECT_EQ (appended.position, u + 2);
+    EXPECT_EQ (u[0], char(0xd1));
+    EXPECT_EQ (u[1], char(0x88));
+
+    appended = utf8::nothrow::append(0xd800, u);
+    EXPECT_EQ (appended.error, utf8::internal::INVALID_CODE_POINT);
+    EXPECT_EQ (appended.position, u);
+    EXPECT_EQ (u[0], char(0xd1));
+}
+
+TEST(NothrowAPITests, test_next)
+{
+    const char* twochars = "\xe6\x97\xa5\xd1\x88";
+    utf8::nothrow::outcome<utf8::utfchar32_t, const char*> decoded = utf8::nothrow::next(twochars, twochars + 5);
+    EXPECT_EQ (decoded.value, 0x65e5u);
+    EXPECT_EQ (decoded.error, utf8::internal::UTF8_OK);
+    EXPECT_EQ (decoded.position, twochars + 3);
+
+    decoded = utf8::nothrow::next(twochars, twochars + 2);
+    EXPECT_EQ (decoded.error, utf8::internal::NOT_ENOUGH_ROOM);
+    EXPECT_EQ (decoded.position, twochars);
+
+    const char* invalid = "\xd1\x41";
+    decoded = utf8::nothrow::next(invalid, invalid + 2);
+    EXPECT_EQ (decoded.error, utf8::internal::INCOMPLETE_SEQUENCE);
+    EXPECT_EQ (decoded.position, invalid);
+}
+
+TEST(NothrowAPITests, test_prior)
+{
+    const char* twochars = "\xe6\x97\xa5\xd1\x88";
+    utf8::nothrow::outcome<utf8::utfchar32_t, const char*> decoded = utf8::nothrow::prior(twochars + 5, twochars);
+    EXPECT_EQ (decoded.value, 0x0448u);
+    EXPECT_EQ (decoded.error, utf8::internal::UTF8_OK);
+    EXPECT_EQ (decoded.position, twochars + 3);
+
+    decoded = utf8::nothrow::prior(twochars, twochars);
+    EXPECT_EQ (decoded.error, utf8::internal::NOT_ENOUGH_ROOM);
+    decoded = utf8::nothrow::prior(twochars + 2, twochars + 1);
+    EXPECT_EQ (decoded.error, utf8::internal::INVALID_LEAD);
+}
+
+TEST(NothrowAPITests, test_advance)
+{
+    const char* threechars = "\xf0\x90\x8d\x86\xe6\x97\xa5\xd1\x88";
+    const char* end = threechars + 9;
+    utf8::nothrow::outcome<int, const char*> moved = utf8::nothrow::advance(threechars, 2, end);
+    EXPECT_EQ (moved.value, 2);
+    EXPECT_EQ (moved.error, utf8::internal::UTF8_OK);
+    EXPECT_EQ (moved.position, threechars + 7);
+
+    moved = utf8::nothrow::advance(end, -2, threechars);
+    EXPECT_EQ (moved.value, -2);
+    EXPECT_EQ (moved.position, threechars + 4);
+
+    // Stops before the code point that is not there
+    moved = utf8::nothrow::advance(threechars, 4, end);
+    EXPECT_EQ (moved.value, 3);
+    EXPECT_EQ (moved.error, utf8::internal::NOT_ENOUGH_ROOM);
+    EXPECT_EQ (moved.position, end);
+
+    // Long input is skipped in bulk up to the invalid sequence
+    string text;
+    while (text.size() < 40000)
+        text += "a\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    text[30001] = '\xff';
+    const char* start = text.data();
+    moved = utf8::nothrow::advance(start, 16000, start + text.size());
+    EXPECT_EQ (moved.value, 12001);
+    EXPECT_EQ (moved.error, utf8::internal::INVALID_LEAD);
+    EXPECT_EQ (moved.position, start + 30001);
+}
+
+TEST(NothrowAPITests, test_conversions)
+{
+    // Long enough for the vectorized kernels
+    string text;
+    for (size_t i = 0; i < 200; ++i)
+        text += "a\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    const char* start = text.data();
+    const char* end = start + text.size();
+
+    vector<unsigned short> utf16(text.size());
+    utf8::nothrow::outcome<unsigned short*, const char*> to16 = utf8::nothrow::utf8to16(start, end, &utf16[0]);
+    EXPECT_EQ (to16.error, utf8::internal::UTF8_OK);
+    EXPECT_EQ (to16.position, end);
+    EXPECT_EQ (to16.value, &utf16[0] + 1000);
+
+    string utf8result;
+    utf8::nothrow::outcome<back_insert_iterator<string>, unsigned short*> from16 =
+        utf8::nothrow::utf16to8(&utf16[0], to16.value, back_inserter(utf8result));
+    EXPECT_EQ (from16.error, utf8::internal::UTF8_OK);
+    EXPECT_TRUE (utf8result == text);
+
+    vector<unsigned int> utf32(text.size());
+    utf8::nothrow::outcome<unsigned int*, const char*> to32 = utf8::nothrow::utf8to32(start, end, &utf32[0]);
+    EXPECT_EQ (to32.error, utf8::internal::UTF8_OK);
+    EXPECT_EQ (to32.value, &utf32[0] + 800);
+
+    utf8result.clear();
+    utf8::nothrow::outcome<back_insert_iterator<string>, unsigned int*> from32 =
+        utf8::nothrow::utf32to8(&utf32[0], to32.value, back_inserter(utf8result));
+    EXPECT_EQ (from32.error, utf8::internal::UTF8_OK);
+    EXPECT_TRUE (utf8result == text);
+
+    // Everything before the first error is converted
+    string invalid = text;
+    invalid[1002] = 'z';
+    to16 = utf8::nothrow::utf8to16(invalid.data(), invalid.data() + invalid.size(), &utf16[0]);
+    EXPECT_EQ (to16.error, utf8::internal::INCOMPLETE_SEQUENCE);
+    EXPECT_EQ (to16.position, invalid.data() + 1001);
+    EXPECT_EQ (to16.value, &utf16[0] + 501);
+
+    utf16[700] = 0xdc00;
+    utf8result.clear();
+    from16 = utf8::nothrow::utf16to8(&utf16[0], &utf16[0] + 1000, back_inserter(utf8result));
+    EXPECT_EQ (from16.error, utf8::internal::INVALID_LEAD);
+    EXPECT_EQ (from16.position, &utf16[0] + 700);
+    EXPECT_EQ (utf8result.size(), 1400u);
+
+    utf32[500] = 0x110000;
+    utf8result.clear();
+    from32 = utf8::nothrow::utf32to8(&utf32[0], &utf32[0] + 800, back_inserter(utf8result));
+    EXPECT_EQ (from32.error, utf8::internal::INVALID_CODE_POINT);
+    EXPECT_EQ (from32.position, &utf32[0] + 500);
+    EXPECT_EQ (utf8result.size(), 1250u);
+}
+
+#endif
@@ -8,6 +8,15 @@
 
 using namespace std;
 
+// Valid text long enough for the bulk counting in advance and distance
+static string unchecked_mixed_text()
+{
+    string text;
+    for (size_t i = 0; i < 50; ++i)
+        text += string(i % 7, 'a') + "\xd1\x88\xe6\x97\xa5\xf0\x9d\x84\x9e";
+    return text;
+}
+
 TEST(UnCheckedAPITests, test_append)
 {
     unsigned char u[5] = {0,0,0,0,0};
@@ -135,6 +144,40 @@ TEST(UnCheckedAPITests, test_advance)
     EXPECT_EQ(w, threechars + 4);
     utf8::unchecked::advance(w, -1);
     EXPECT_EQ(w, threechars);
+
+    // Long enough to be counted in bulk, from every code point within a block
+    const string text = unchecked_mixed_text();
+    for (size_t i = 0; i < 64; ++i) {
+        size_t first = i, last = text.size() - i;
+        while (utf8::internal::is_trail(text[first]))
+            ++first;
+        while (last != text.size() && utf8::internal::is_trail(text[last]))
+            --last;
+        const string part = text.substr(first, last - first);
+        const char* start = part.data();
+        const char* end = start + part.size();
+        const ptrdiff_t code_points = utf8::unchecked::distance(start, end);
+        w = start;
+        utf8::unchecked::advance(w, code_points / 2);
+        string::const_iterator it = part.begin();
+        utf8::unchecked::advance(it, code_points / 2);
+        EXPECT_EQ(w - start, it - part.begin());
+        utf8::unchecked::advance(w, code_points - code_points / 2);
+        EXPECT_EQ(w, end);
+        utf8::unchecked::advance(w, -code_points);
+        EXPECT_EQ(w, start);
+    }
+
+    // A run of trail octets is stepped over one octet at a time, as it is
+    // without the bulk counting, and no further
+    const string trails = string(32, 'a') + string(40, '\x80') + string(32, 'z');
+    const char* trails_start = trails.data();
+    w = trails_start;
+    utf8::unchecked::advance(w, 80);
+    EXPECT_EQ(w, trails_start + 80);
+    w = trails_start + trails.size();
+    utf8::unchecked::advance(w, -33);
+    EXPECT_EQ(w, trails_start + 31);
 }
 
 TEST(UnCheckedAPITests, test_distance)
@@ -142,6 +185,19 @@ TEST(UnCheckedAPITests, test_distance)
     const char* twochars = "\xe6\x97\xa5\xd1\x88";
     size_t dist = static_cast<size_t>(utf8::unchecked::distance(twochars, twochars + 5));
     EXPECT_EQ (dist, 2);
+
+    // Long enough for the vectorized counter, from and to every position
+    // within a block
+    const string text = unchecked_mixed_text();
+    for (size_t i = 0; i < 64; ++i) {
+        const string part = text.substr(i, text.size() - 2 * i);
+        size_t code_points = 0;
+        for (size_t j = 0; j < part.size(); ++j)
+            if ((static_cast<unsigned char>(part[j]) & 0xc0) != 0x80)
+                ++code_points;
+        EXPECT_EQ (static_cast<size_t>(utf8::unchecked::distance(part.data(), part.data() + part.size())), code_points);
+        EXPECT_EQ (static_cast<size_t>(utf8::unchecked::distance(part.begin(), part.end())), code_points);
+    }
 }
 
 TEST(UnCheckedAPITests, test_utf32to8)